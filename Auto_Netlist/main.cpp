@@ -912,6 +912,15 @@ int main(int argc, char* argv[]) {
     string intermediate_file = "output.txt";
     string final_netlist_file = "netlist_final.txt";
 
+    // Argumentos: [arquivo.vo [arquivo_intermediario [netlist_final]]]
+    if (argc > 4) {
+        cerr << "Uso: " << argv[0] << " [arquivo.vo [arquivo_intermediario [netlist_final]]]" << endl;
+        return 1;
+    }
+    if (argc > 1) vo_filename = argv[1];
+    if (argc > 2) intermediate_file = argv[2];
+    if (argc > 3) final_netlist_file = argv[3];
+
     cout << "--- Etapa 1: Gerando arquivo intermediário ---" << endl;
     if (!generateIntermediateFile(vo_filename, intermediate_file)) {
         cerr << "Falha ao gerar o arquivo intermediário. Abortando." << endl;
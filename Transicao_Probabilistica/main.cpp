@@ -1,647 +1,4915 @@
 #include <bits/stdc++.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
 
 using namespace std;
 
-// Estrutura para armazenar informações de um elemento da netlist
-struct Element {
+// Códigos de operação (opcodes) dos elementos da netlist
+enum GateOp : uint8_t {
+    OP_INPT,
+    OP_OUT,
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_NAND,
+    OP_NOR,
+    OP_XNOR,
+    OP_NOT,
+    OP_MUX,
+    OP_SUM_SUB,
+    OP_MACRO,  // Instância de uma macro-célula declarada no arquivo (Netlist::macros)
+    OP_UNKNOWN // Tipos não suportados (ex: "gate" gerado pelo Auto_Netlist); não são avaliados
+};
+
+// Nomes dos tipos no formato texto da netlist, indexados pelo opcode
+const char* const OP_NAMES[] = {"inpt", "out", "and", "or", "xor", "nand", "nor", "xnor", "not", "mux", "sum_sub", "macro", "gate"};
+
+// Pinos de saída além da saída principal, indexados pelo opcode (sum_sub: pino 2 = carry-out; macros: uma saída a
+// menos que as declaradas no corpo). Uma conexão "17.p" lê o pino p; os pinos 0 e 1 (ou sem sufixo) são a saída principal
+const uint8_t OP_EXTRA_PINS[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0};
+constexpr int MAX_EXTRA_PINS = 15;
+
+// Quantidade exata de entradas dos tipos com entradas posicionais, indexada pelo opcode (mux: A, B, Sel;
+// sum_sub: A, B, Cin, Op); 0 = quantidade variável
+const uint8_t OP_FIXED_FANIN[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 4, 0, 0};
+
+// Converte o tipo lido do arquivo para o opcode correspondente (instâncias de macros são resolvidas pelo leitor)
+uint8_t opFromName(string_view type) {
+    for (uint8_t op = 0; op < OP_UNKNOWN; ++op) {
+        if (op != OP_MACRO && type == OP_NAMES[op]) return op;
+    }
+    return OP_UNKNOWN;
+}
+
+
+
+
+
+// Contadores do heap: os operadores new/delete globais são substituídos por malloc/free com contagem das
+// alocações e dos bytes vivos (tamanho real do bloco, quando a plataforma o informa); o pico é o maior valor
+// dos bytes vivos. Sem --stats, 'counting' fica desligado e new/delete apenas testam o flag, sem operações atômicas;
+// ligado antes de qualquer thread, conta as alocações a partir desse ponto
+struct HeapCounters {
+    bool counting = false;
+    atomic<uint64_t> allocations{0};
+    atomic<int64_t> live_bytes{0};
+    atomic<int64_t> peak_bytes{0};
+};
+
+HeapCounters heap_counters;
+
+inline size_t heapBlockSize(void* p) {
+#if defined(__GLIBC__)
+    return malloc_usable_size(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return 0;
+#endif
+}
+
+[[gnu::noinline]] void* countedAlloc(size_t size, size_t alignment = 0) {
+    void* p = alignment > alignof(max_align_t) ? aligned_alloc(alignment, (max<size_t>(size, 1) + alignment - 1) / alignment * alignment)
+                                               : malloc(max<size_t>(size, 1));
+    if (!p || !heap_counters.counting) return p;
+    heap_counters.allocations.fetch_add(1, memory_order_relaxed);
+    const int64_t block = heapBlockSize(p);
+    const int64_t live = heap_counters.live_bytes.fetch_add(block, memory_order_relaxed) + block;
+    int64_t peak = heap_counters.peak_bytes.load(memory_order_relaxed);
+    while (live > peak && !heap_counters.peak_bytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    return p;
+}
+
+[[gnu::noinline]] void countedFree(void* p) {
+    if (!p) return;
+    if (heap_counters.counting) heap_counters.live_bytes.fetch_sub(heapBlockSize(p), memory_order_relaxed);
+    free(p);
+}
+
+void* operator new(size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(size_t size, align_val_t alignment) {
+    if (void* p = countedAlloc(size, size_t(alignment))) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t size, align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { countedFree(p); }
+void operator delete(void* p, align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { countedFree(p); }
+
+
+
+
+
+// Instrumentação por fase (--stats, --stats-json F): tempo acumulado de cada fase medido por temporizadores RAII
+// e contadores de elementos avaliados por opcode, caminhos enumerados e bytes gravados
+// Desativada por padrão: um ScopedTimer desligado apenas testa 'enabled' e não lê o relógio
+struct PhaseCounter {
+    const char* name;
+    uint64_t calls = 0;
+    double total_ms = 0.0;
+    uint64_t bytes = 0;  // Bytes gravados pelas fases de escrita
+    uint64_t allocations = 0; // Alocações do heap durante a fase (de todo o processo)
+};
+
+struct Instrumentation {
+    bool enabled = false;
+    vector<PhaseCounter> phases;            // Na ordem da primeira execução de cada fase
+    uint64_t gates_by_op[OP_UNKNOWN + 1] = {};
+    uint64_t paths_enumerated = 0;
+    uint64_t macro_cache_hits = 0;
+    uint64_t macro_cache_misses = 0;
+    uint64_t bytes_written = 0;
+    mutex lock;                             // Fases e contadores são atualizados pelas threads da triagem e dos manifestos
+
+    void recordPhase(const char* name, double elapsed_ms, uint64_t bytes, uint64_t allocations) {
+        lock_guard<mutex> guard(lock);
+        auto it = find_if(phases.begin(), phases.end(), [&](const PhaseCounter& phase) { return strcmp(phase.name, name) == 0; });
+        if (it == phases.end()) it = phases.insert(phases.end(), PhaseCounter{name});
+        it->calls++;
+        it->total_ms += elapsed_ms;
+        it->bytes += bytes;
+        it->allocations += allocations;
+        bytes_written += bytes;
+    }
+
+    void countGates(const uint64_t (&counts)[OP_UNKNOWN + 1], uint64_t cache_hits, uint64_t cache_misses) {
+        lock_guard<mutex> guard(lock);
+        for (int op = 0; op <= OP_UNKNOWN; ++op) gates_by_op[op] += counts[op];
+        macro_cache_hits += cache_hits;
+        macro_cache_misses += cache_misses;
+    }
+
+    void countPaths(uint64_t paths) {
+        lock_guard<mutex> guard(lock);
+        paths_enumerated += paths;
+    }
+};
+
+Instrumentation instrumentation;
+
+// Temporizador de escopo: acumula o tempo entre a construção e a destruição na fase 'name' (uma string literal)
+// As fases podem ser aninhadas (ex: "levelize" dentro de "parse"); cada uma registra o seu tempo total
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name(instrumentation.enabled ? name : nullptr) {
+        if (!this->name) return;
+        start = chrono::steady_clock::now();
+        allocations = heap_counters.allocations.load(memory_order_relaxed);
+    }
+    ~ScopedTimer() {
+        if (!name) return;
+        const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        instrumentation.recordPhase(name, elapsed, bytes, heap_counters.allocations.load(memory_order_relaxed) - allocations);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Bytes gravados pela fase (ex: posição final do arquivo de saída)
+    void addBytes(int64_t count) {
+        if (name && count > 0) bytes += count;
+    }
+
+private:
+    const char* name;
+    chrono::steady_clock::time_point start;
+    uint64_t bytes = 0;
+    uint64_t allocations = 0;  // Contador do heap no início da fase
+};
+
+// Pico de memória residente do processo em bytes (0 se indisponível)
+uint64_t peakResidentBytes() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return usage.ru_maxrss;         // bytes no macOS
+#else
+    return usage.ru_maxrss * 1024;  // KB no Linux
+#endif
+#else
+    return 0;
+#endif
+}
+
+struct MacroCell;
+
+// Estrutura densa (struct-of-arrays) da netlist
+// Os nós são indexados de 0 a n-1 em ordem crescente de ID; todas as conexões usam esses índices.
+// As entradas de cada nó ficam em um array CSR: fanin[fanin_offset[i] .. fanin_offset[i + 1]).
+// Para mux a ordem é (A, B, Sel) e para sum_sub é (A, B, Cin, Op).
+struct Netlist {
+    vector<int> ids;                 // ID original de cada nó
+    vector<uint8_t> ops;             // Opcode de cada nó
+    vector<uint32_t> name_offset;    // Nome do comentário "//nome" de cada nó em name_pool (n + 1 posições)
+    string name_pool;
+
+    vector<uint32_t> fanin_offset;   // CSR das entradas (n + 1 posições)
+    vector<int> fanin;
+    vector<uint8_t> fanin_pin;       // Pino lido por cada conexão ("17.2" -> 2); a conexão é o par (fanin, fanin_pin)
+    vector<uint32_t> fanout_offset;  // CSR das saídas (n + 1 posições)
+    vector<int> fanout;
+
+    vector<int> topo_order;          // Nós em ordem topológica, agrupados por nível
+    vector<uint32_t> level_offset;   // Início de cada nível em topo_order (níveis + 1 posições)
+
+    vector<double> prob_0;           // Probabilidade de ocorrer nível lógico 0 (saída principal)
+    vector<double> prob_1;           // Probabilidade de ocorrer nível lógico 1 (saída principal)
+    vector<uint32_t> pin_offset;     // CSR dos pinos extras (n + 1 posições): o pino p >= 2 do nó é o sinal pin_offset[nó] + p - 2
+    vector<double> pin_prob_0;       // Probabilidades dos pinos extras (ex: carry-out do sum_sub)
+    vector<double> pin_prob_1;
+
+    vector<shared_ptr<MacroCell>> macros; // Macro-células declaradas no arquivo (compartilhadas entre cópias da netlist)
+    vector<uint32_t> macro_index;    // Macro de cada nó OP_MACRO em 'macros' (vazio quando não há macros)
+
+    size_t size() const { return ids.size(); }
+    string_view name(int node) const {
+        return string_view(name_pool).substr(name_offset[node], name_offset[node + 1] - name_offset[node]);
+    }
+    uint32_t faninCount(int node) const { return fanin_offset[node + 1] - fanin_offset[node]; }
+    const int* faninBegin(int node) const { return fanin.data() + fanin_offset[node]; }
+
+    // Sinal lido pela conexão k: posição em pin_prob_* ou -1 para a saída principal (inclusive pinos inexistentes)
+    int pinSlot(uint32_t k) const {
+        if (fanin_pin[k] < 2) return -1;
+        const uint32_t slot = pin_offset[fanin[k]] + fanin_pin[k] - 2;
+        return slot < pin_offset[fanin[k] + 1] ? (int)slot : -1;
+    }
+};
+
+// Quantidade de entradas de um nó que fazem parte dos caminhos lógicos (exclui Sel do mux e Op do sum_sub)
+inline uint32_t pathFaninCount(const Netlist& netlist, int node) {
+    const uint32_t count = netlist.faninCount(node);
+    if (netlist.ops[node] == OP_MUX) return min<uint32_t>(count, 2);
+    if (netlist.ops[node] == OP_SUM_SUB) return min<uint32_t>(count, 3);
+    return count;
+}
+
+
+
+
+
+// Função para ordenar a netlist em níveis (ordenação topológica pelo algoritmo de Kahn)
+// Também constrói o CSR de saídas; cada nível contém apenas nós cujas entradas estão em níveis anteriores
+void levelizeNetlist(Netlist& netlist) {
+    ScopedTimer timer("levelize");
+    const int n = netlist.size();
+
+    // CSR das saídas a partir do CSR das entradas
+    netlist.fanout_offset.assign(n + 1, 0);
+    for (int source : netlist.fanin) netlist.fanout_offset[source + 1]++;
+    for (int i = 0; i < n; ++i) netlist.fanout_offset[i + 1] += netlist.fanout_offset[i];
+    netlist.fanout.resize(netlist.fanin.size());
+    vector<uint32_t> cursor(netlist.fanout_offset.begin(), netlist.fanout_offset.end() - 1);
+    for (int node = 0; node < n; ++node) {
+        for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+            netlist.fanout[cursor[netlist.fanin[k]]++] = node;
+        }
+    }
+
+    // Quantidade de dependências ainda não resolvidas de cada nó
+    vector<uint32_t> pending_inputs(n);
+    netlist.topo_order.clear();
+    netlist.topo_order.reserve(n);
+    netlist.level_offset.assign(1, 0);
+    for (int node = 0; node < n; ++node) {
+        pending_inputs[node] = netlist.faninCount(node);
+        if (pending_inputs[node] == 0) netlist.topo_order.push_back(node);
+    }
+
+    // O próprio topo_order funciona como fila: cada nível é o intervalo adicionado pelo nível anterior
+    size_t level_begin = 0;
+    while (level_begin < netlist.topo_order.size()) {
+        const size_t level_end = netlist.topo_order.size();
+        netlist.level_offset.push_back(level_end);
+        for (size_t k = level_begin; k < level_end; ++k) {
+            const int node = netlist.topo_order[k];
+            for (uint32_t e = netlist.fanout_offset[node]; e < netlist.fanout_offset[node + 1]; ++e) {
+                const int target = netlist.fanout[e];
+                if (--pending_inputs[target] == 0) netlist.topo_order.push_back(target);
+            }
+        }
+        level_begin = level_end;
+    }
+
+    // Nós que nunca atingiram zero dependências pertencem a (ou dependem de) um ciclo
+    if (netlist.topo_order.size() != netlist.size()) {
+        stringstream ss;
+        ss << "Cyclic dependency detected in netlist (elements:";
+        for (int node = 0; node < n; ++node) {
+            if (pending_inputs[node] > 0) ss << " " << netlist.ids[node];
+        }
+        ss << ")";
+        throw runtime_error(ss.str());
+    }
+}
+
+
+
+
+
+// Arquivo mapeado somente para leitura (mmap em sistemas POSIX; nos demais, lido inteiro para a memória)
+class MappedFile {
+public:
+    explicit MappedFile(const string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            size_ = info.st_size;
+            valid_ = true;
+            if (size_ > 0) {
+                int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+                flags |= MAP_POPULATE; // Pré-carrega as páginas: a leitura é sequencial e completa
+#endif
+                void* data = ::mmap(nullptr, size_, PROT_READ, flags, fd, 0);
+                if (data == MAP_FAILED) {
+                    valid_ = false;
+                    size_ = 0;
+                } else {
+                    mapping_ = data;
+                    data_ = static_cast<const char*>(data);
+                }
+            }
+        }
+        ::close(fd);
+#else
+        ifstream file(filename, ios::binary);
+        if (!file.is_open()) return;
+        buffer_.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        valid_ = true;
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapping_) ::munmap(mapping_, size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return valid_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool valid_ = false;
+#if defined(__unix__) || defined(__APPLE__)
+    void* mapping_ = nullptr;
+#else
+    string buffer_;
+#endif
+};
+
+// Hash de 64 bits do conteúdo de um arquivo (blocos de 8 bytes combinados com multiplicações e rotações)
+inline uint64_t hashBytes(const char* data, size_t size) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ (word * 0xC2B2AE3D27D4EB4Full)) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 31;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    h = (h ^ (tail * 0xC2B2AE3D27D4EB4Full)) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+// Registros de elementos na ordem do arquivo, ainda referenciando as conexões pelos IDs originais
+struct NetlistRecords {
+    vector<int> ids;
+    vector<uint8_t> ops;
+    vector<uint32_t> ref_offset = {0};
+    vector<int> ref_ids;
+    vector<uint8_t> ref_pins;
+    vector<uint32_t> name_offset = {0};
+    string names;
+
+    vector<shared_ptr<MacroCell>> macros;             // Macros declaradas, na ordem do arquivo
+    vector<pair<uint32_t, uint32_t>> macro_instances; // (registro, macro) de cada instância
+
+    size_t size() const { return ids.size(); }
+};
+
+// Macro-célula: sub-circuito declarado uma única vez no arquivo e instanciado como um tipo de elemento
+//   macro <nome>
+//   <elementos no formato da netlist, com IDs locais>
+//   end
+// As entradas da macro são os elementos "inpt" do corpo e as saídas os elementos "out", ambos em ordem de ID; a
+// instância lê as entradas na ordem da sua linha de conexões e expõe a saída k (k >= 2) no pino k ("17.2", como o carry-out)
+// O corpo é compilado em um kernel linear: os elementos internos em ordem topológica, avaliados sobre um banco de
+// registradores (um por elemento e um por pino extra do corpo) com o mesmo evaluateNode da netlist
+constexpr size_t MAX_MACRO_INPUTS = 32;
+constexpr size_t MACRO_CACHE_SLOTS = 4096;              // Potência de 2
+constexpr double MACRO_CACHE_QUANTUM = 4294967296.0;    // As probabilidades da chave são quantizadas em passos de 2^-32
+
+struct MacroCell {
+    string name;
+    NetlistRecords source;      // Corpo lido do arquivo (liberado depois da compilação)
+    Netlist body;               // Corpo compilado: IDs locais, levelizado
+    vector<int> inputs;         // Registradores das entradas, na ordem das conexões da instância
+    vector<int> outputs;        // Registradores das saídas (a primeira é a saída principal da instância)
+    vector<int> kernel;         // Elementos internos em ordem topológica, sem as entradas
+    size_t registers = 0;
+    uint64_t signature = 0;     // Hash do nome e da estrutura do corpo (usado pelos hashes estruturais)
+
+    // Memoização da propagação escalar: tabela de mapeamento direto indexada pelo hash das probabilidades das entradas
+    // quantizadas; guarda a chave completa e as probabilidades de todas as saídas (bits dos doubles). As cópias da
+    // netlist usadas pelas threads (triagem, manifestos) compartilham a macro, então cada entrada é protegida por um
+    // seqlock: a versão fica ímpar durante a escrita e o leitor descarta a entrada se a versão mudou durante a leitura
+    vector<atomic<uint64_t>> cache_keys;     // MACRO_CACHE_SLOTS * 2 * entradas
+    vector<atomic<uint64_t>> cache_values;   // MACRO_CACHE_SLOTS * 2 * saídas
+    vector<atomic<uint32_t>> cache_version;  // Por entrada: 0 = vazia, ímpar = em escrita
+    atomic<uint64_t> cache_hits{0};          // Acertos e faltas ainda não somados à instrumentação (só com --stats)
+    atomic<uint64_t> cache_misses{0};
+};
+
+// Pinos extras de um nó: conforme o opcode ou, nas instâncias de macros, as saídas além da principal
+inline uint32_t extraOutputPins(const Netlist& netlist, int node) {
+    if (netlist.ops[node] == OP_MACRO) return netlist.macros[netlist.macro_index[node]]->outputs.size() - 1;
+    return OP_EXTRA_PINS[netlist.ops[node]];
+}
+
+// Função para criar os pinos extras de cada nó conforme o opcode, com probabilidades iniciais genéricas
+void assignOutputPins(Netlist& netlist) {
+    const int n = netlist.size();
+    netlist.pin_offset.assign(n + 1, 0);
+    for (int node = 0; node < n; ++node) {
+        netlist.pin_offset[node + 1] = netlist.pin_offset[node] + extraOutputPins(netlist, node);
+    }
+    netlist.pin_prob_0.assign(netlist.pin_offset[n], 1.0);
+    netlist.pin_prob_1.assign(netlist.pin_offset[n], 1.0);
+}
+
+// Nova probabilidade de um elemento de entrada
+struct InputProbabilityChange {
     int id;
-    string type;
-    vector<float> connections; // Conexões gerais (entradas ou saídas)
-    vector<float> selectors;   // Conexões específicas, como seletoras de mux ou op de sum_sub
-    double prob_0;           // Probabilidade de ocorrer nível lógico 0
-    double prob_1;           // Probabilidade de ocorrer nível lógico 1
-    double carry_out_prob_0; // Probabilidade de carry_out ser 0 (somente para sum_sub)
-    double carry_out_prob_1; // Probabilidade de carry_out ser 1 (somente para sum_sub)
+    double prob_0;
+    double prob_1;
+};
+
+// Alterações a aplicar sobre uma netlist já propagada, referenciando os elementos pelos IDs originais
+// Um elemento em 'elements' com ID novo é adicionado; com ID existente, substitui o tipo, o nome (se informado)
+// e as conexões do elemento (troca de tipo, religação de entradas)
+struct NetlistDelta {
+    NetlistRecords elements;                    // Elementos adicionados ou redefinidos
+    vector<int> removed_ids;                    // Elementos removidos (nenhum elemento restante pode referenciá-los)
+    vector<InputProbabilityChange> input_probs; // Aplicadas depois das alterações estruturais
+};
+
+// Leitor do formato texto sobre o arquivo mapeado: percorre o buffer com ponteiros e converte os números com
+// from_chars, sem criar strings nem streams por linha (os registros vão direto para os arrays de NetlistRecords)
+class NetlistScanner {
+public:
+    NetlistScanner(const char* begin, const char* end, const string& filename) : p_(begin), end_(end), filename_(filename) {}
+
+    // Lê todos os registros do arquivo (as macros precisam ser declaradas antes da primeira instância)
+    void scan(NetlistRecords& records) {
+        string_view line;
+        while (nextLine(line)) {
+            string_view rest = skipSpaces(line);
+            if (rest.empty()) continue; // Ignorar linhas em branco
+            if (token(rest) == "macro") {
+                readMacro(line, records);
+                continue;
+            }
+            readRecord(line, records);
+        }
+    }
+
+    // Lê um arquivo de alterações: além dos elementos e macros, aceita as linhas "remove" e "prob" e comentários
+    // iniciados por '#'. As macros da netlist ('netlist_macros') podem ser instanciadas pelo nome e ocupam os
+    // primeiros índices de delta.elements.macros; as declaradas no arquivo vêm depois delas
+    void scan(NetlistDelta& delta, const vector<shared_ptr<MacroCell>>& netlist_macros) {
+        for (const auto& macro : netlist_macros) {
+            macro_names_.emplace(macro->name, delta.elements.macros.size());
+            delta.elements.macros.push_back(macro);
+        }
+
+        string_view line;
+        while (nextLine(line)) {
+            string_view rest = skipSpaces(line);
+            if (rest.empty() || rest[0] == '#') continue; // Ignorar linhas em branco e comentários
+            const string_view keyword = token(rest);
+            if (keyword == "remove") {
+                int id;
+                for (string_view t = token(rest); !t.empty(); t = token(rest)) {
+                    if (!parseInt(t, id)) throw runtime_error("Malformed 'remove' line in " + location() + ": " + string(line));
+                    delta.removed_ids.push_back(id);
+                }
+            } else if (keyword == "prob") {
+                InputProbabilityChange change;
+                if (!parseInt(token(rest), change.id) || !parseDouble(token(rest), change.prob_0) || !parseDouble(token(rest), change.prob_1)) {
+                    throw runtime_error("Malformed 'prob' line in " + location() + ": " + string(line));
+                }
+                delta.input_probs.push_back(change);
+            } else if (keyword == "macro") {
+                readMacro(line, delta.elements);
+            } else {
+                readRecord(line, delta.elements);
+            }
+        }
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    const string& filename_;
+    size_t line_number_ = 0;                      // Linha atual (a última lida por nextLine), para as mensagens de erro
+    unordered_map<string, uint32_t> macro_names_; // Nome -> índice em records.macros
+
+    string location() const { return filename_ + ":" + to_string(line_number_); }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+    static string_view skipSpaces(string_view s) {
+        size_t i = 0;
+        while (i < s.size() && isSpace(s[i])) i++;
+        return s.substr(i);
+    }
+
+    // Próximo token separado por espaços; 'rest' avança para depois dele
+    static string_view token(string_view& rest) {
+        rest = skipSpaces(rest);
+        size_t i = 0;
+        while (i < rest.size() && !isSpace(rest[i])) i++;
+        const string_view t = rest.substr(0, i);
+        rest.remove_prefix(i);
+        return t;
+    }
+
+    static bool parseInt(string_view t, int& value) {
+        return !t.empty() && from_chars(t.data(), t.data() + t.size(), value).ec == errc();
+    }
+
+    static bool parseDouble(string_view t, double& value) {
+        return !t.empty() && from_chars(t.data(), t.data() + t.size(), value).ec == errc();
+    }
+
+    bool nextLine(string_view& line) {
+        if (p_ >= end_) return false;
+        const char* newline = static_cast<const char*>(memchr(p_, '\n', end_ - p_));
+        const char* line_end = newline ? newline : end_;
+        line = string_view(p_, line_end - p_);
+        p_ = newline ? newline + 1 : end_;
+        line_number_++;
+        return true;
+    }
+
+    // Lê uma linha de conexões no formato "id" ou "id.2" (carry-out de sum_sub)
+    void readConnections(size_t expected, NetlistRecords& records) {
+        string_view line;
+        if (!nextLine(line)) {
+            throw runtime_error("Unexpected end of file in " + filename_);
+        }
+        size_t count = 0;
+        for (string_view t = token(line); !t.empty(); t = token(line)) {
+            int id = 0, pin = 0;
+            const auto [dot, error] = from_chars(t.data(), t.data() + t.size(), id);
+            if (error != errc() || (dot != t.data() + t.size() && (*dot != '.' || !parseInt(t.substr(dot - t.data() + 1), pin)))) {
+                throw runtime_error("Element " + to_string(records.ids.back()) + " in " + location() + " has a malformed connection line");
+            }
+            if (pin < 0 || pin > UINT8_MAX) {
+                // Os pinos são guardados em 8 bits: "17.256" não pode virar silenciosamente o pino 0
+                throw runtime_error("Element " + to_string(records.ids.back()) + " in " + location() + " reads out-of-range pin " + string(t));
+            }
+            records.ref_ids.push_back(id);
+            records.ref_pins.push_back(pin);
+            count++;
+        }
+        if (expected != 0 && count != expected) {
+            throw runtime_error("Element " + to_string(records.ids.back()) + " in " + location() + " has a malformed connection line");
+        }
+    }
+
+    // Lê um elemento ("id tipo saídas entradas //nome") e as suas linhas de conexão
+    void readRecord(string_view line, NetlistRecords& records) {
+        string_view rest = line;
+        int id, num_outputs, num_inputs;
+        const string_view id_token = token(rest);
+        const string_view type = token(rest);
+        if (!parseInt(id_token, id) || type.empty() || !parseInt(token(rest), num_outputs) || !parseInt(token(rest), num_inputs)) {
+            throw runtime_error("Malformed element header in " + location() + ": " + string(line));
+        }
+        uint8_t op = opFromName(type);
+        if (op == OP_UNKNOWN && !macro_names_.empty()) {
+            const auto macro = macro_names_.find(string(type));
+            if (macro != macro_names_.end()) {
+                op = OP_MACRO;
+                records.macro_instances.emplace_back(records.ids.size(), macro->second);
+            }
+        }
+        records.ids.push_back(id);
+        records.ops.push_back(op);
+
+        // Nome do elemento, quando presente como comentário "//nome"
+        const size_t comment = line.find("//");
+        if (comment != string_view::npos) {
+            string_view name = line.substr(comment + 2);
+            while (!name.empty() && (name.back() == ' ' || name.back() == '\t' || name.back() == '\r')) name.remove_suffix(1);
+            records.names.append(name.data(), name.size());
+        }
+        records.name_offset.push_back(records.names.size());
+
+        if (op == OP_SUM_SUB) {
+            // Três linhas específicas para sum_sub: entradas (A B), carry_in e operando
+            readConnections(2, records);
+            readConnections(1, records);
+            readConnections(1, records);
+        } else if (op == OP_MUX) {
+            // Duas linhas para mux: entradas (A B) e seletor
+            readConnections(2, records);
+            readConnections(1, records);
+        } else if (op != OP_INPT && num_inputs > 0) {
+            // Demais elementos: uma linha com todas as entradas
+            readConnections(0, records);
+        }
+        records.ref_offset.push_back(records.ref_ids.size());
+    }
+
+    // Lê uma declaração "macro <nome>" e o corpo até "end"
+    void readMacro(string_view line, NetlistRecords& records) {
+        string_view rest = line;
+        token(rest);
+        const string name(token(rest));
+        if (name.empty() || !token(rest).empty()) {
+            throw runtime_error("Malformed macro declaration in " + location() + ": " + string(line));
+        }
+        if (opFromName(name) != OP_UNKNOWN || name == OP_NAMES[OP_MACRO] || macro_names_.count(name)) {
+            throw runtime_error("Macro " + name + " in " + location() + " redefines an existing type");
+        }
+
+        auto macro = make_shared<MacroCell>();
+        macro->name = name;
+        string_view body_line;
+        while (nextLine(body_line)) {
+            string_view body_rest = skipSpaces(body_line);
+            if (body_rest.empty()) continue;
+            const string_view keyword = token(body_rest);
+            if (keyword == "end") {
+                macro_names_.emplace(name, records.macros.size());
+                records.macros.push_back(move(macro));
+                return;
+            }
+            if (keyword != "macro") readRecord(body_line, macro->source);
+            if (keyword == "macro" || macro->source.ops.back() == OP_MACRO) {
+                throw runtime_error("Macro " + name + " in " + location() + " contains another macro; nested macros are not supported");
+            }
+        }
+        throw runtime_error("Macro " + name + " in " + location() + " is missing 'end'");
+    }
+};
+
+void compileMacro(MacroCell& macro, const string& filename);
+
+// Função para construir a netlist densa a partir dos registros lidos
+void buildNetlist(NetlistRecords& records, const string& filename, Netlist& netlist) {
+    // Índices densos em ordem crescente de ID; em IDs repetidos prevalece o último registro
+    const int max_id = records.ids.empty() ? -1 : *max_element(records.ids.begin(), records.ids.end());
+    if (max_id >= 0 && (size_t)max_id > 16 * records.ids.size() + 1024) {
+        throw runtime_error("Element IDs in " + filename + " are too sparse");
+    }
+    vector<int> id_to_record(max_id + 1, -1);
+    bool ordered = true; // IDs estritamente crescentes no arquivo: a ordem dos registros já é a ordem densa
+    for (size_t r = 0; r < records.ids.size(); ++r) {
+        if (records.ids[r] < 0) throw runtime_error("Negative element ID in " + filename);
+        id_to_record[records.ids[r]] = r;
+        if (r > 0 && records.ids[r] <= records.ids[r - 1]) ordered = false;
+    }
+    vector<int> id_to_index(max_id + 1, -1);
+    netlist = Netlist();
+
+    auto resolve = [&](int node, int source_id) {
+        if (source_id < 0 || source_id > max_id || id_to_index[source_id] < 0) {
+            throw runtime_error("Element " + to_string(netlist.ids[node]) + " references undefined element " + to_string(source_id));
+        }
+        return id_to_index[source_id];
+    };
+
+    if (ordered) {
+        // Caso comum: os arrays dos registros são movidos para a netlist e só as conexões são remapeadas no lugar
+        id_to_index = move(id_to_record);
+        netlist.ids = move(records.ids);
+        netlist.ops = move(records.ops);
+        netlist.name_pool = move(records.names);
+        netlist.name_offset = move(records.name_offset);
+        netlist.fanin_offset = move(records.ref_offset);
+        netlist.fanin = move(records.ref_ids);
+        netlist.fanin_pin = move(records.ref_pins);
+        for (size_t node = 0; node < netlist.size(); ++node) {
+            for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+                netlist.fanin[k] = resolve(node, netlist.fanin[k]);
+            }
+        }
+    } else {
+        for (int id = 0; id <= max_id; ++id) {
+            if (id_to_record[id] >= 0) {
+                id_to_index[id] = netlist.ids.size();
+                netlist.ids.push_back(id);
+            }
+        }
+
+        const int n = netlist.ids.size();
+        netlist.ops.resize(n);
+        netlist.name_offset.assign(1, 0);
+        netlist.fanin_offset.assign(1, 0);
+        for (int node = 0; node < n; ++node) {
+            const int r = id_to_record[netlist.ids[node]];
+            netlist.ops[node] = records.ops[r];
+            netlist.name_pool.append(records.names, records.name_offset[r], records.name_offset[r + 1] - records.name_offset[r]);
+            netlist.name_offset.push_back(netlist.name_pool.size());
+            for (uint32_t k = records.ref_offset[r]; k < records.ref_offset[r + 1]; ++k) {
+                netlist.fanin.push_back(resolve(node, records.ref_ids[k]));
+                netlist.fanin_pin.push_back(records.ref_pins[k]);
+            }
+            netlist.fanin_offset.push_back(netlist.fanin.size());
+        }
+    }
+
+    // Tipos com entradas posicionais precisam exatamente da sua quantidade de entradas (evaluateNode lê cada posição)
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        const uint8_t op = netlist.ops[node];
+        if (OP_FIXED_FANIN[op] != 0 && netlist.faninCount(node) != OP_FIXED_FANIN[op]) {
+            throw runtime_error("Element " + to_string(netlist.ids[node]) + " (" + OP_NAMES[op] + ") in " + filename + " has "
+                                + to_string(netlist.faninCount(node)) + " inputs; expected " + to_string(OP_FIXED_FANIN[op]));
+        }
+    }
+
+    // Macros: compiladas uma vez; cada instância guarda o índice da sua macro
+    if (!records.macros.empty()) {
+        netlist.macros = move(records.macros);
+        for (const auto& macro : netlist.macros) compileMacro(*macro, filename);
+        netlist.macro_index.assign(netlist.size(), 0);
+        for (const auto& [r, macro] : records.macro_instances) {
+            if (ordered) {
+                netlist.macro_index[r] = macro;
+            } else if (id_to_record[records.ids[r]] == (int)r) {
+                netlist.macro_index[id_to_index[records.ids[r]]] = macro;
+            }
+        }
+    }
+
+    // Inicializar probabilidades: padrão para "inpt", valores iniciais genéricos para outros tipos
+    const int n = netlist.size();
+    netlist.prob_0.assign(n, 1.0);
+    netlist.prob_1.assign(n, 1.0);
+    assignOutputPins(netlist);
+    for (int node = 0; node < n; ++node) {
+        if (netlist.ops[node] == OP_INPT) {
+            netlist.prob_0[node] = 0.25; // Probabilidade padrão para 0
+            netlist.prob_1[node] = 0.25; // Probabilidade padrão para 1
+        }
+    }
+
+    levelizeNetlist(netlist);
+}
+
+// Função para ler o formato texto já mapeado em memória e construir o grafo da netlist
+void parseNetlistText(const MappedFile& text, const string& filename, Netlist& netlist) {
+    NetlistRecords records;
+    // Estimativa pelo tamanho do arquivo (uma linha de cabeçalho e uma de conexões por elemento, ~24 bytes)
+    records.ids.reserve(text.size() / 24);
+    records.ops.reserve(text.size() / 24);
+    records.ref_ids.reserve(text.size() / 12);
+    records.ref_pins.reserve(text.size() / 12);
+    NetlistScanner(text.data(), text.data() + text.size(), filename).scan(records);
+    buildNetlist(records, filename, netlist);
+}
+
+
+
+
+
+// Cache binário da netlist, gravado ao lado do arquivo texto (<netlist>.txt.cache)
+// Layout: cabeçalho seguido dos arrays densos (ids, ops, nomes, CSRs, ordem topológica e probabilidades iniciais),
+// cada um alinhado em 8 bytes. O cache guarda o tamanho e o hash do texto de origem e é descartado quando o texto muda;
+// o carregamento é um único mmap seguido de cópias em bloco, sem nenhuma conversão de texto
+constexpr char NETLIST_CACHE_MAGIC[8] = {'T', 'P', 'N', 'E', 'T', 'B', 'I', 'N'};
+constexpr uint32_t NETLIST_CACHE_VERSION = 2;
+
+struct NetlistCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_check;  // 0x01020304 gravado na ordem de bytes da máquina
+    uint64_t text_size;
+    uint64_t text_hash;
+    uint64_t nodes;
+    uint64_t connections;
+    uint64_t levels;
+    uint64_t name_pool_size;
+};
+
+// Desativado por --no-cache (ex: diretórios somente leitura ou medições do parser de texto)
+bool netlist_cache_enabled = true;
+
+inline string netlistCachePath(const string& filename) {
+    return filename + ".cache";
+}
+
+// Função para gravar o cache binário de uma netlist recém-lida do texto
+// A gravação é feita em um arquivo temporário renomeado no final, então leitores concorrentes nunca veem um cache parcial
+void saveNetlistCache(const string& filename, const Netlist& netlist, uint64_t text_size, uint64_t text_hash) {
+    // O formato binário não guarda os corpos das macros; netlists com macros são sempre lidas do texto
+    if (!netlist.macros.empty()) return;
+    ScopedTimer timer("write_cache");
+    NetlistCacheHeader header{};
+    memcpy(header.magic, NETLIST_CACHE_MAGIC, sizeof(header.magic));
+    header.version = NETLIST_CACHE_VERSION;
+    header.endian_check = 0x01020304;
+    header.text_size = text_size;
+    header.text_hash = text_hash;
+    header.nodes = netlist.size();
+    header.connections = netlist.fanin.size();
+    header.levels = netlist.level_offset.size() - 1;
+    header.name_pool_size = netlist.name_pool.size();
+
+    stringstream suffix;
+    suffix << ".tmp" << hash<thread::id>()(this_thread::get_id());
+    const string cache_path = netlistCachePath(filename);
+    const string temp_path = cache_path + suffix.str();
+    ofstream file(temp_path, ios::binary);
+    if (!file.is_open()) return; // Diretório sem permissão de escrita: a netlist continua sendo lida do texto
+
+    size_t written = 0;
+    auto write = [&](const void* data, size_t bytes) {
+        file.write(static_cast<const char*>(data), bytes);
+        written += bytes;
+        static const char padding[8] = {};
+        file.write(padding, (8 - written % 8) % 8);
+        written += (8 - written % 8) % 8;
+    };
+    write(&header, sizeof(header));
+    write(netlist.ids.data(), netlist.ids.size() * sizeof(int));
+    write(netlist.ops.data(), netlist.ops.size());
+    write(netlist.name_offset.data(), netlist.name_offset.size() * sizeof(uint32_t));
+    write(netlist.name_pool.data(), netlist.name_pool.size());
+    write(netlist.fanin_offset.data(), netlist.fanin_offset.size() * sizeof(uint32_t));
+    write(netlist.fanin.data(), netlist.fanin.size() * sizeof(int));
+    write(netlist.fanin_pin.data(), netlist.fanin_pin.size());
+    write(netlist.fanout_offset.data(), netlist.fanout_offset.size() * sizeof(uint32_t));
+    write(netlist.fanout.data(), netlist.fanout.size() * sizeof(int));
+    write(netlist.topo_order.data(), netlist.topo_order.size() * sizeof(int));
+    write(netlist.level_offset.data(), netlist.level_offset.size() * sizeof(uint32_t));
+    write(netlist.prob_0.data(), netlist.prob_0.size() * sizeof(double));
+    write(netlist.prob_1.data(), netlist.prob_1.size() * sizeof(double));
+    file.close();
+    timer.addBytes(written);
+
+    error_code error;
+    if (file) {
+        std::filesystem::rename(temp_path, cache_path, error);
+    }
+    if (!file || error) std::filesystem::remove(temp_path, error);
+}
+
+// Função para validar os arrays lidos do cache antes de usá-los como índices: IDs crescentes, opcodes conhecidos
+// (o cache não guarda macros), offsets começando em 0, não decrescentes e terminando no tamanho do array,
+// conexões e ordem topológica dentro de [0, n), a ordem topológica como permutação dos nós e a quantidade exata de
+// entradas de mux e sum_sub
+bool validCacheArrays(const Netlist& netlist) {
+    const size_t n = netlist.size();
+    auto validOffsets = [](const vector<uint32_t>& offsets, size_t size) {
+        if (offsets.empty() || offsets.front() != 0 || offsets.back() != size) return false;
+        return is_sorted(offsets.begin(), offsets.end());
+    };
+    auto validNodes = [n](const vector<int>& nodes) {
+        return all_of(nodes.begin(), nodes.end(), [n](int node) { return node >= 0 && (size_t)node < n; });
+    };
+
+    if (adjacent_find(netlist.ids.begin(), netlist.ids.end(), greater_equal<int>()) != netlist.ids.end()) return false;
+    if (any_of(netlist.ops.begin(), netlist.ops.end(), [](uint8_t op) { return op > OP_UNKNOWN || op == OP_MACRO; })) return false;
+    if (!validOffsets(netlist.name_offset, netlist.name_pool.size()) || !validOffsets(netlist.fanin_offset, netlist.fanin.size())
+        || !validOffsets(netlist.fanout_offset, netlist.fanout.size()) || !validOffsets(netlist.level_offset, netlist.topo_order.size())) {
+        return false;
+    }
+    if (!validNodes(netlist.fanin) || !validNodes(netlist.fanout) || !validNodes(netlist.topo_order)) return false;
+    for (size_t node = 0; node < n; ++node) {
+        const uint8_t fixed = OP_FIXED_FANIN[netlist.ops[node]];
+        if (fixed != 0 && netlist.fanin_offset[node + 1] - netlist.fanin_offset[node] != fixed) return false;
+    }
+
+    vector<char> seen(n, 0);
+    for (int node : netlist.topo_order) {
+        if (seen[node]) return false;
+        seen[node] = 1;
+    }
+    return true;
+}
+
+// Função para carregar a netlist do cache binário
+// Retorna false (sem alterar a netlist) quando o cache não existe, é de outra versão, não corresponde ao texto atual
+// ou está corrompido (arrays inconsistentes); nesses casos a netlist é lida do texto e o cache regravado
+bool loadNetlistCache(const string& filename, Netlist& netlist, uint64_t text_size, uint64_t text_hash) {
+    ScopedTimer timer("load_cache");
+    const MappedFile cache(netlistCachePath(filename));
+    if (!cache.valid() || cache.size() < sizeof(NetlistCacheHeader)) return false;
+
+    NetlistCacheHeader header;
+    memcpy(&header, cache.data(), sizeof(header));
+    if (memcmp(header.magic, NETLIST_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != NETLIST_CACHE_VERSION
+        || header.endian_check != 0x01020304 || header.text_size != text_size || header.text_hash != text_hash) {
+        return false;
+    }
+
+    // Cada array é validado contra o tamanho do arquivo antes de ser copiado
+    size_t offset = 0;
+    bool truncated = false;
+    auto read = [&](auto& target, size_t count) {
+        using T = typename remove_reference_t<decltype(target)>::value_type;
+        offset = (offset + 7) / 8 * 8;
+        if (truncated || count > (cache.size() - min(offset, cache.size())) / sizeof(T)) {
+            truncated = true;
+            return;
+        }
+        const T* begin = reinterpret_cast<const T*>(cache.data() + offset);
+        target.assign(begin, begin + count);
+        offset += count * sizeof(T);
+    };
+
+    const size_t n = header.nodes, m = header.connections;
+    Netlist loaded;
+    offset = sizeof(header);
+    read(loaded.ids, n);
+    read(loaded.ops, n);
+    read(loaded.name_offset, n + 1);
+    read(loaded.name_pool, header.name_pool_size);
+    read(loaded.fanin_offset, n + 1);
+    read(loaded.fanin, m);
+    read(loaded.fanin_pin, m);
+    read(loaded.fanout_offset, n + 1);
+    read(loaded.fanout, m);
+    read(loaded.topo_order, n);
+    read(loaded.level_offset, header.levels + 1);
+    read(loaded.prob_0, n);
+    read(loaded.prob_1, n);
+    if (truncated || !validCacheArrays(loaded)) return false;
+
+    assignOutputPins(loaded);
+    netlist = move(loaded);
+    return true;
+}
+
+// Função para ler o arquivo e construir o grafo da netlist
+// Usa o cache binário quando ele corresponde ao texto atual; caso contrário lê o texto e regrava o cache.
+// Um arquivo inexistente lança runtime_error, como os erros de formato
+void parseNetlist(const string& filename, Netlist& netlist) {
+    ScopedTimer timer("parse");
+    const MappedFile text(filename);
+    if (!text.valid()) {
+        throw runtime_error("Could not open file " + filename);
+    }
+    if (!netlist_cache_enabled) {
+        parseNetlistText(text, filename, netlist);
+        return;
+    }
+
+    const uint64_t text_hash = hashBytes(text.data(), text.size());
+    if (loadNetlistCache(filename, netlist, text.size(), text_hash)) return;
+    parseNetlistText(text, filename, netlist);
+    saveNetlistCache(filename, netlist, text.size(), text_hash);
+}
+
+
+
+
+
+// Par de probabilidades (nível 0, nível 1) de um sinal
+// V é double na propagação escalar ou um vetor SIMD com vários cenários (LaneVec) na propagação em lote
+template <class V>
+struct ProbPair {
+    V p0;
+    V p1;
+};
+
+// Fórmulas das portas lógicas, assumindo entradas independentes
+// As portas compostas (nand, nor, xnor, mux e sum_sub) são escritas para qualquer tipo de sinal S que
+// ofereça probNot/probAnd/probOr/probXor; assim os motores exatos reutilizam exatamente a mesma decomposição
+template <class V>
+inline ProbPair<V> probNot(const ProbPair<V>& x) {
+    return {x.p1, x.p0};
+}
+
+template <class V>
+inline ProbPair<V> probAnd(const ProbPair<V>& x, const ProbPair<V>& y) {
+    return {x.p0 + y.p0 - (x.p0 * y.p0), x.p1 * y.p1};
+}
+
+template <class V>
+inline ProbPair<V> probOr(const ProbPair<V>& x, const ProbPair<V>& y) {
+    return {x.p0 * y.p0, x.p1 + y.p1 - (x.p1 * y.p1)};
+}
+
+template <class V>
+inline ProbPair<V> probXor(const ProbPair<V>& x, const ProbPair<V>& y) {
+    return {x.p0 * y.p0 + x.p1 * y.p1, x.p0 * y.p1 + x.p1 * y.p0};
+}
+
+// Mux decomposto em AC + B~C (usado pelos motores exatos: BDD, tabela-verdade e Monte Carlo)
+template <class S>
+inline S probMux(const S& a, const S& b, const S& c) {
+    const S ac = probAnd(a, c);
+    const S bnc = probAnd(b, probNot(c));
+    return probOr(ac, bnc);
+}
+
+// Mux na propagação heurística (ProbPair): mantém a forma fechada original, que troca as probabilidades de ~C
+// no segundo termo e portanto calcula AC + BC; assim os valores padrão continuam iguais aos da versão original
+template <class V>
+inline ProbPair<V> probMux(const ProbPair<V>& a, const ProbPair<V>& b, const ProbPair<V>& c) {
+    const ProbPair<V> ac = probAnd(a, c);
+    const ProbPair<V> bnc = probAnd(b, c);
+    return probOr(ac, bnc);
+}
+
+// Somador/subtrator decomposto em portas; retorna a saída principal e escreve o carry-out (pino 2) em 'carry'
+template <class S>
+inline S probSumSub(const S& a, const S& b, const S& cin, const S& op, S& carry) {
+    const S not_a = probNot(a);
+    const S not_b = probNot(b);
+    const S not_op = probNot(op);
+
+    // Termos da saída principal: (A ~B Cin), (A B Cin), (~A ~B Cin) e (~A B Cin)
+    const S t1 = probAnd(probAnd(a, not_b), cin);
+    const S t2 = probAnd(probAnd(a, b), cin);
+    const S t3 = probAnd(probAnd(not_a, not_b), cin);
+    const S t4 = probAnd(probAnd(not_a, b), cin);
+
+    // Termos do carry-out: (B Cin), (~Op A Cin), (Op ~A Cin), (Op ~A B) e (~Op A B)
+    const S not_op_a = probAnd(not_op, a);
+    const S op_not_a = probAnd(op, not_a);
+    const S ct1 = probOr(probOr(probAnd(b, cin), probAnd(not_op_a, cin)), probAnd(op_not_a, cin));
+    const S ct2 = probOr(probAnd(op_not_a, b), probAnd(not_op_a, b));
+
+    carry = probOr(ct1, ct2);
+    return probOr(probOr(t1, t2), probOr(t3, t4));
+}
+
+template <class S>
+bool evaluateMacro(const MacroCell& macro, const S* inputs, uint32_t count, S& out, S* pins);
+
+// Avalia um nó a partir das probabilidades das suas entradas
+// load(fonte, slot) lê a saída principal (slot -1) ou o pino extra 'slot' de um nó (Netlist::pinSlot);
+// os pinos extras do nó avaliado são escritos em pins[0 .. OP_EXTRA_PINS[op])
+// As portas and/or/xor/nand/nor/xnor aceitam qualquer quantidade (>= 2) de entradas: a fatia CSR é reduzida em
+// sequência com a fórmula de duas entradas, que é associativa sob a hipótese de independência
+// (and: P(1) = produto dos P(1), P(0) = 1 - produto dos (1 - P(0)); xor: paridade acumulada)
+// Retorna false quando o nó não é avaliado (tipo não suportado ou conexões insuficientes)
+template <class S, class Load>
+inline bool evaluateNode(const Netlist& netlist, int node, Load&& load, S& out, S* pins) {
+    const uint32_t begin = netlist.fanin_offset[node];
+    const uint32_t count = netlist.faninCount(node);
+    const int* fanin = netlist.faninBegin(node);
+    if (count == 0) return false;
+    auto input = [&](uint32_t k) { return load(fanin[k], netlist.pinSlot(begin + k)); };
+    auto reduce = [&](auto&& combine) {
+        S acc = input(0);
+        for (uint32_t k = 1; k < count; ++k) acc = combine(acc, input(k));
+        return acc;
+    };
+    auto and_all = [&] { return reduce([](const S& x, const S& y) { return probAnd(x, y); }); };
+    auto or_all = [&] { return reduce([](const S& x, const S& y) { return probOr(x, y); }); };
+    auto xor_all = [&] { return reduce([](const S& x, const S& y) { return probXor(x, y); }); };
+
+    switch (netlist.ops[node]) {
+        case OP_NOT:
+            out = probNot(input(0));
+            return true;
+        case OP_AND:
+            if (count < 2) return false;
+            out = and_all();
+            return true;
+        case OP_OR:
+            if (count < 2) return false;
+            out = or_all();
+            return true;
+        case OP_XOR:
+            if (count < 2) return false;
+            out = xor_all();
+            return true;
+        case OP_NAND:
+            if (count < 2) return false;
+            out = probNot(and_all());
+            return true;
+        case OP_NOR:
+            if (count < 2) return false;
+            out = probNot(or_all());
+            return true;
+        case OP_XNOR:
+            if (count < 2) return false;
+            out = probNot(xor_all());
+            return true;
+        case OP_MUX:
+            if (count != OP_FIXED_FANIN[OP_MUX]) return false;
+            out = probMux(input(0), input(1), input(2));
+            return true;
+        case OP_SUM_SUB:
+            if (count != OP_FIXED_FANIN[OP_SUM_SUB]) return false;
+            out = probSumSub(input(0), input(1), input(2), input(3), pins[0]);
+            return true;
+        case OP_OUT:
+            out = input(0);
+            return true;
+        case OP_MACRO: {
+            S values[MAX_MACRO_INPUTS];
+            const uint32_t used = min<uint32_t>(count, MAX_MACRO_INPUTS);
+            for (uint32_t k = 0; k < used; ++k) values[k] = input(k);
+            return evaluateMacro(*netlist.macros[netlist.macro_index[node]], values, used, out, pins);
+        }
+        default:
+            return false;
+    }
+}
+
+// Banco de registradores dos kernels de macro, um por thread e por tipo de sinal (macros não são aninhadas)
+template <class S>
+vector<S>& macroRegisters() {
+    thread_local vector<S> registers;
+    return registers;
+}
+
+// Leitura de sinais dentro do kernel de uma macro: nós e pinos vivem no mesmo banco de registradores. É um tipo
+// nomeado (não um lambda) para que evaluateNode e evaluateMacro se instanciem uma única vez por tipo de sinal
+template <class S>
+struct MacroLoad {
+    const S* registers;
+    size_t pins;
+    S operator()(int source, int slot) const { return slot < 0 ? registers[source] : registers[pins + slot]; }
+};
+
+// Executa o kernel de uma macro: entradas nos registradores, elementos internos em ordem topológica, saídas copiadas
+template <class S>
+bool evaluateMacro(const MacroCell& macro, const S* inputs, uint32_t count, S& out, S* pins) {
+    if (count < macro.inputs.size()) return false;
+    vector<S>& registers = macroRegisters<S>();
+    if (registers.size() < macro.registers) registers.resize(macro.registers);
+
+    const Netlist& body = macro.body;
+    const size_t n = body.size();
+    for (size_t k = 0; k < macro.inputs.size(); ++k) registers[macro.inputs[k]] = inputs[k];
+    MacroLoad<S> load{registers.data(), n};
+    for (int node : macro.kernel) {
+        if (!evaluateNode(body, node, load, registers[node], registers.data() + n + body.pin_offset[node])) return false;
+    }
+    out = registers[macro.outputs[0]];
+    for (size_t k = 1; k < macro.outputs.size(); ++k) pins[k - 1] = registers[macro.outputs[k]];
+    return true;
+}
+
+
+
+
+
+// Indica se evaluateNode consegue avaliar o nó (tipo suportado e conexões suficientes)
+inline bool canEvaluateNode(const Netlist& netlist, int node) {
+    const uint32_t count = netlist.faninCount(node);
+    switch (netlist.ops[node]) {
+        case OP_NOT:
+        case OP_OUT:
+            return count >= 1;
+        case OP_MUX:
+        case OP_SUM_SUB:
+            return count == OP_FIXED_FANIN[netlist.ops[node]];
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
+        case OP_NAND:
+        case OP_NOR:
+        case OP_XNOR:
+            return count >= 2;
+        case OP_MACRO:
+            return count >= netlist.macros[netlist.macro_index[node]]->inputs.size();
+        default:
+            return false;
+    }
+}
+
+// Função para compilar o corpo de uma macro no kernel linear e preparar a sua memoização
+void compileMacro(MacroCell& macro, const string& filename) {
+    const string context = filename + " (macro " + macro.name + ")";
+    buildNetlist(macro.source, context, macro.body);
+    macro.source = NetlistRecords();
+
+    const Netlist& body = macro.body;
+    for (size_t node = 0; node < body.size(); ++node) {
+        if (body.ops[node] == OP_INPT) macro.inputs.push_back(node);
+        if (body.ops[node] == OP_OUT) macro.outputs.push_back(node);
+    }
+    if (macro.inputs.empty() || macro.outputs.empty()) {
+        throw runtime_error("Macro " + macro.name + " in " + filename + " needs at least one inpt and one out element");
+    }
+    if (macro.inputs.size() > MAX_MACRO_INPUTS || macro.outputs.size() > MAX_EXTRA_PINS + 1) {
+        throw runtime_error("Macro " + macro.name + " in " + filename + " has more than " + to_string(MAX_MACRO_INPUTS)
+                            + " inputs or " + to_string(MAX_EXTRA_PINS + 1) + " outputs");
+    }
+    for (int node : body.topo_order) {
+        if (body.ops[node] == OP_INPT) continue;
+        if (!canEvaluateNode(body, node)) {
+            throw runtime_error("Element " + to_string(body.ids[node]) + " (" + OP_NAMES[body.ops[node]] + ") in " + context + " cannot be evaluated");
+        }
+        macro.kernel.push_back(node);
+    }
+    macro.registers = body.size() + body.pin_prob_0.size();
+
+    macro.signature = hashBytes(macro.name.data(), macro.name.size());
+    macro.signature ^= hashBytes(reinterpret_cast<const char*>(body.ops.data()), body.ops.size()) * 0x9E3779B97F4A7C15ull;
+    macro.signature ^= hashBytes(reinterpret_cast<const char*>(body.fanin.data()), body.fanin.size() * sizeof(int)) * 0xC2B2AE3D27D4EB4Full;
+    macro.signature ^= hashBytes(reinterpret_cast<const char*>(body.fanin_pin.data()), body.fanin_pin.size());
+
+    macro.cache_keys = vector<atomic<uint64_t>>(MACRO_CACHE_SLOTS * 2 * macro.inputs.size());
+    macro.cache_values = vector<atomic<uint64_t>>(MACRO_CACHE_SLOTS * 2 * macro.outputs.size());
+    macro.cache_version = vector<atomic<uint32_t>>(MACRO_CACHE_SLOTS);
+}
+
+
+
+
+
+// Função para avaliar uma instância de macro pela tabela de memoização: instâncias cujas entradas têm as mesmas
+// probabilidades (até a quantização da chave) reutilizam o resultado em vez de executar o kernel
+void calculateMacroProbability(Netlist& netlist, int node) {
+    MacroCell& macro = *netlist.macros[netlist.macro_index[node]];
+    const size_t inputs = macro.inputs.size(), outputs = macro.outputs.size();
+    const uint32_t begin = netlist.fanin_offset[node];
+    if (netlist.faninCount(node) < inputs) return;
+
+    ProbPair<double> values[MAX_MACRO_INPUTS];
+    uint64_t key[2 * MAX_MACRO_INPUTS];
+    for (size_t k = 0; k < inputs; ++k) {
+        const int source = netlist.fanin[begin + k], slot = netlist.pinSlot(begin + k);
+        values[k] = slot < 0 ? ProbPair<double>{netlist.prob_0[source], netlist.prob_1[source]}
+                             : ProbPair<double>{netlist.pin_prob_0[slot], netlist.pin_prob_1[slot]};
+        key[2 * k] = (uint64_t)llround(values[k].p0 * MACRO_CACHE_QUANTUM);
+        key[2 * k + 1] = (uint64_t)llround(values[k].p1 * MACRO_CACHE_QUANTUM);
+    }
+    const size_t entry = hashBytes(reinterpret_cast<const char*>(key), 2 * inputs * sizeof(uint64_t)) & (MACRO_CACHE_SLOTS - 1);
+    atomic<uint64_t>* cached_key = macro.cache_keys.data() + entry * 2 * inputs;
+    atomic<uint64_t>* cached_value = macro.cache_values.data() + entry * 2 * outputs;
+    atomic<uint32_t>& version = macro.cache_version[entry];
+
+    // Leitura: a chave e os valores só valem se a versão era par (não vazia) e não mudou durante a cópia
+    double cached[2 * (MAX_EXTRA_PINS + 1)];
+    const uint32_t read_version = version.load(memory_order_acquire);
+    bool hit = read_version != 0 && read_version % 2 == 0;
+    for (size_t k = 0; hit && k < 2 * inputs; ++k) hit = cached_key[k].load(memory_order_relaxed) == key[k];
+    if (hit) {
+        for (size_t k = 0; k < 2 * outputs; ++k) {
+            const uint64_t bits = cached_value[k].load(memory_order_relaxed);
+            memcpy(&cached[k], &bits, sizeof(double));
+        }
+        atomic_thread_fence(memory_order_acquire);
+        hit = version.load(memory_order_relaxed) == read_version;
+    }
+
+    if (hit) {
+        if (instrumentation.enabled) macro.cache_hits.fetch_add(1, memory_order_relaxed);
+    } else {
+        if (instrumentation.enabled) macro.cache_misses.fetch_add(1, memory_order_relaxed);
+        ProbPair<double> out, pins[MAX_EXTRA_PINS];
+        if (!evaluateMacro(macro, values, inputs, out, pins)) return;
+        cached[0] = out.p0;
+        cached[1] = out.p1;
+        for (size_t k = 1; k < outputs; ++k) {
+            cached[2 * k] = pins[k - 1].p0;
+            cached[2 * k + 1] = pins[k - 1].p1;
+        }
+
+        // Escrita: só se nenhuma outra thread estiver escrevendo a entrada (senão o resultado apenas não é guardado)
+        uint32_t write_version = version.load(memory_order_relaxed);
+        if (write_version % 2 == 0 && version.compare_exchange_strong(write_version, write_version + 1, memory_order_relaxed)) {
+            atomic_thread_fence(memory_order_release);
+            for (size_t k = 0; k < 2 * inputs; ++k) cached_key[k].store(key[k], memory_order_relaxed);
+            for (size_t k = 0; k < 2 * outputs; ++k) {
+                uint64_t bits;
+                memcpy(&bits, &cached[k], sizeof(double));
+                cached_value[k].store(bits, memory_order_relaxed);
+            }
+            version.store(write_version + 2, memory_order_release);
+        }
+    }
+
+    netlist.prob_0[node] = cached[0];
+    netlist.prob_1[node] = cached[1];
+    for (uint32_t slot = netlist.pin_offset[node], k = 1; slot < netlist.pin_offset[node + 1]; ++slot, ++k) {
+        netlist.pin_prob_0[slot] = cached[2 * k];
+        netlist.pin_prob_1[slot] = cached[2 * k + 1];
+    }
+}
+
+// Função para calcular probabilidades para portas lógicas e elementos especiais
+void calculateElementProbability(Netlist& netlist, int node) {
+    if (netlist.ops[node] == OP_MACRO) {
+        calculateMacroProbability(netlist, node);
+        return;
+    }
+    auto load = [&](int source, int slot) {
+        return slot < 0 ? ProbPair<double>{netlist.prob_0[source], netlist.prob_1[source]}
+                        : ProbPair<double>{netlist.pin_prob_0[slot], netlist.pin_prob_1[slot]};
+    };
+
+    ProbPair<double> out{}, pins[MAX_EXTRA_PINS];
+    if (evaluateNode(netlist, node, load, out, pins)) {
+        netlist.prob_0[node] = out.p0;
+        netlist.prob_1[node] = out.p1;
+        for (uint32_t slot = netlist.pin_offset[node], k = 0; slot < netlist.pin_offset[node + 1]; ++slot, ++k) {
+            netlist.pin_prob_0[slot] = pins[k].p0;
+            netlist.pin_prob_1[slot] = pins[k].p1;
+        }
+    }
+}
+
+
+
+
+
+// Conta por opcode os elementos avaliados em uma travessia e os acertos da memoização das macros desde a
+// última contagem (somente com a instrumentação ativa)
+void countEvaluatedGates(const Netlist& netlist, const vector<int>& nodes) {
+    if (!instrumentation.enabled) return;
+    uint64_t counts[OP_UNKNOWN + 1] = {};
+    for (int node : nodes) {
+        if (netlist.ops[node] != OP_INPT) counts[netlist.ops[node]]++;
+    }
+    uint64_t cache_hits = 0, cache_misses = 0;
+    for (const auto& macro : netlist.macros) {
+        cache_hits += macro->cache_hits.exchange(0, memory_order_relaxed);
+        cache_misses += macro->cache_misses.exchange(0, memory_order_relaxed);
+    }
+    instrumentation.countGates(counts, cache_hits, cache_misses);
+}
+
+void calculateProbabilities(Netlist& netlist) {
+    ScopedTimer timer("propagate");
+    // A netlist já foi levelizada no parsing; cada nó é avaliado exatamente uma vez,
+    // depois de todas as suas dependências
+    for (int node : netlist.topo_order) {
+        calculateElementProbability(netlist, node);
+    }
+    countEvaluatedGates(netlist, netlist.topo_order);
+}
+
+
+
+
+
+// Função para ler um arquivo de alterações:
+//   remove <ID> [<ID> ...]
+//   prob <ID> <P(0)> <P(1)>
+//   <ID> <tipo> <saídas> <entradas> [//nome] seguido das linhas de conexão, como na netlist
+//   macro <nome> ... end, como na netlist
+// Linhas em branco e iniciadas por '#' são ignoradas; as macros de 'netlist' podem ser instanciadas
+NetlistDelta parseNetlistDelta(const string& filename, const Netlist& netlist) {
+    const MappedFile text(filename);
+    if (!text.valid()) {
+        throw runtime_error("Could not open delta file " + filename);
+    }
+
+    NetlistDelta delta;
+    NetlistScanner(text.data(), text.data() + text.size(), filename).scan(delta, netlist.macros);
+    for (size_t k = netlist.macros.size(); k < delta.elements.macros.size(); ++k) compileMacro(*delta.elements.macros[k], filename);
+    return delta;
+}
+
+
+
+
+
+inline uint64_t mix64(uint64_t x);
+
+// Nós do cone -> dependências pendentes. Enquanto o cone é pequeno, fica em uma tabela aberta (sondagem linear)
+// que cresce com o cone; quando passa de 1/16 da netlist, muda para arrays indexados pelo nó, cujo custo
+// (O(n) = O(16 · cone)) continua proporcional ao cone e evita as faltas de cache da tabela nos cones grandes
+class ConeTable {
+public:
+    explicit ConeTable(size_t nodes) : nodes(nodes) {}
+
+    bool contains(int node) const { return dense() ? in_cone[node] : keys[slot(node)] == node; }
+    uint32_t& operator[](int node) { return dense() ? values[node] : values[slot(node)]; }
+
+    // Insere o nó (com zero dependências); retorna false se já estava no cone
+    bool insert(int node) {
+        if (dense()) {
+            if (in_cone[node]) return false;
+            in_cone[node] = 1;
+            count++;
+            return true;
+        }
+        if ((count + 1) * 16 > nodes) {
+            // Cone grande: arrays densos
+            vector<uint32_t> old_values(nodes, 0);
+            in_cone.assign(nodes, 0);
+            for (size_t k = 0; k < keys.size(); ++k) {
+                if (keys[k] != -1) {
+                    in_cone[keys[k]] = 1;
+                    old_values[keys[k]] = values[k];
+                }
+            }
+            values.swap(old_values);
+            keys = vector<int>();
+            return insert(node);
+        }
+        if ((count + 1) * 2 > keys.size()) rehash(max<size_t>(64, keys.size() * 2));
+        const size_t s = slot(node);
+        if (keys[s] == node) return false;
+        keys[s] = node;
+        count++;
+        return true;
+    }
+
+private:
+    size_t nodes;
+    size_t count = 0;
+    vector<int> keys;          // Tabela aberta (-1 = vazio)
+    vector<uint32_t> values;   // Dependências pendentes (por posição na tabela ou por nó)
+    vector<char> in_cone;      // Modo denso: pertinência ao cone por nó
+
+    bool dense() const { return !in_cone.empty(); }
+
+    size_t slot(int node) const {
+        const size_t mask = keys.size() - 1;
+        size_t s = mix64(node) & mask;
+        while (keys[s] != node && keys[s] != -1) s = (s + 1) & mask;
+        return s;
+    }
+
+    void rehash(size_t capacity) {
+        vector<int> old_keys(capacity, -1);
+        vector<uint32_t> old_values(capacity, 0);
+        keys.swap(old_keys);
+        values.swap(old_values);
+        for (size_t k = 0; k < old_keys.size(); ++k) {
+            if (old_keys[k] != -1) {
+                const size_t s = slot(old_keys[k]);
+                keys[s] = old_keys[k];
+                values[s] = old_values[k];
+            }
+        }
+    }
+};
+
+// Função para reavaliar apenas o cone de fanout transitivo dos nós alterados
+// O cone é ordenado por um Kahn local (contando só as dependências dentro do cone); a tabela auxiliar guarda
+// apenas os nós do cone, então o custo (avaliações e memória) é proporcional ao tamanho do cone e não ao da
+// netlist; retorna a quantidade de nós reavaliados
+size_t propagateFanoutCone(Netlist& netlist, const vector<int>& changed) {
+    ScopedTimer timer("propagate_delta");
+    ConeTable pending_inputs(netlist.size()); // Nós do cone -> dependências ainda não avaliadas dentro do cone
+    vector<int> cone;
+    for (int node : changed) {
+        if (pending_inputs.insert(node)) cone.push_back(node);
+    }
+    for (size_t k = 0; k < cone.size(); ++k) {
+        const int node = cone[k];
+        for (uint32_t e = netlist.fanout_offset[node]; e < netlist.fanout_offset[node + 1]; ++e) {
+            const int target = netlist.fanout[e];
+            if (pending_inputs.insert(target)) cone.push_back(target);
+        }
+    }
+
+    // Dependências de cada nó do cone dentro do próprio cone (uma por conexão, como no levelizeNetlist)
+    for (int node : cone) {
+        uint32_t pending = 0;
+        for (uint32_t k = 0; k < netlist.faninCount(node); ++k) pending += pending_inputs.contains(netlist.faninBegin(node)[k]);
+        pending_inputs[node] = pending;
+    }
+
+    vector<int> order;
+    order.reserve(cone.size());
+    for (int node : cone) {
+        if (pending_inputs[node] == 0) order.push_back(node);
+    }
+    for (size_t k = 0; k < order.size(); ++k) {
+        const int node = order[k];
+        calculateElementProbability(netlist, node);
+        for (uint32_t e = netlist.fanout_offset[node]; e < netlist.fanout_offset[node + 1]; ++e) {
+            if (--pending_inputs[netlist.fanout[e]] == 0) order.push_back(netlist.fanout[e]);
+        }
+    }
+    countEvaluatedGates(netlist, order);
+    return order.size();
+}
+
+// Função para aplicar um conjunto de alterações a uma netlist já propagada e recalcular somente o cone afetado
+// Alterações apenas de probabilidade são feitas no lugar, em O(cone); alterações estruturais remontam os arrays
+// densos a partir dos arrays atuais (sem reler o arquivo) e relevelizam a netlist inteira, em O(n), porque os nós
+// são indexados em ordem de ID e um ID inserido ou removido desloca todos os seguintes. As probabilidades fora do cone
+// dos elementos alterados são mantidas. Em caso de erro (referência inválida, ciclo) lança runtime_error
+// e a netlist não é alterada. Retorna a quantidade de nós reavaliados
+size_t applyNetlistDelta(Netlist& netlist, const NetlistDelta& delta) {
+    vector<int> changed;
+
+    // Novas probabilidades das entradas, validadas antes de qualquer escrita
+    auto applyInputProbabilities = [&](Netlist& target) {
+        vector<int> nodes;
+        for (const auto& change : delta.input_probs) {
+            const auto it = lower_bound(target.ids.begin(), target.ids.end(), change.id);
+            const int node = it - target.ids.begin();
+            if (it == target.ids.end() || *it != change.id || target.ops[node] != OP_INPT) {
+                throw runtime_error("Delta sets the probability of " + to_string(change.id) + ", which is not an input element");
+            }
+            nodes.push_back(node);
+        }
+        for (size_t k = 0; k < nodes.size(); ++k) {
+            target.prob_0[nodes[k]] = delta.input_probs[k].prob_0;
+            target.prob_1[nodes[k]] = delta.input_probs[k].prob_1;
+            changed.push_back(nodes[k]);
+        }
+    };
+
+    if (delta.elements.size() > 0 || !delta.removed_ids.empty()) {
+        const int old_n = netlist.size();
+        auto findNode = [](const vector<int>& ids, int id) {
+            const auto it = lower_bound(ids.begin(), ids.end(), id);
+            return it != ids.end() && *it == id ? int(it - ids.begin()) : -1;
+        };
+
+        // Elementos removidos e redefinidos (em IDs repetidos prevalece o último registro, como no parser)
+        vector<char> removed(old_n, 0);
+        for (int id : delta.removed_ids) {
+            const int node = findNode(netlist.ids, id);
+            if (node < 0) throw runtime_error("Delta removes undefined element " + to_string(id));
+            removed[node] = 1;
+        }
+        map<int, int> record_by_id;
+        for (size_t r = 0; r < delta.elements.size(); ++r) record_by_id[delta.elements.ids[r]] = r;
+
+        // Novos IDs em ordem crescente: intercalação dos IDs mantidos com os IDs adicionados
+        Netlist updated;
+        auto added = record_by_id.begin();
+        for (int node = 0; node <= old_n; ++node) {
+            const int id = node < old_n ? netlist.ids[node] : INT_MAX;
+            for (; added != record_by_id.end() && added->first < id; ++added) {
+                if (added->first < 0) throw runtime_error("Negative element ID in delta");
+                updated.ids.push_back(added->first);
+            }
+            if (added != record_by_id.end() && added->first == id) ++added;
+            if (node < old_n && (!removed[node] || record_by_id.count(id))) updated.ids.push_back(id);
+        }
+
+        const int n = updated.size();
+        updated.ops.resize(n);
+        updated.name_offset.assign(1, 0);
+        updated.fanin_offset.assign(1, 0);
+        updated.prob_0.assign(n, 1.0);
+        updated.prob_1.assign(n, 1.0);
+        vector<int> old_to_new(old_n, -1);
+        for (int node = 0; node < n; ++node) {
+            const int id = updated.ids[node];
+            const int old = findNode(netlist.ids, id);
+            const auto record = record_by_id.find(id);
+            if (old >= 0) old_to_new[old] = node;
+
+            if (record == record_by_id.end()) {
+                // Elemento mantido: copia tipo, nome, conexões e probabilidades
+                updated.ops[node] = netlist.ops[old];
+                const string_view name = netlist.name(old);
+                updated.name_pool.append(name.data(), name.size());
+                for (uint32_t k = netlist.fanin_offset[old]; k < netlist.fanin_offset[old + 1]; ++k) {
+                    updated.fanin.push_back(netlist.fanin[k]); // Remapeado abaixo, quando old_to_new estiver completo
+                    updated.fanin_pin.push_back(netlist.fanin_pin[k]);
+                }
+                updated.prob_0[node] = netlist.prob_0[old];
+                updated.prob_1[node] = netlist.prob_1[old];
+            } else {
+                // Elemento adicionado ou redefinido: conexões pelos IDs, resolvidas abaixo; nome antigo mantido se omitido
+                const int r = record->second;
+                const NetlistRecords& records = delta.elements;
+                updated.ops[node] = records.ops[r];
+                if (records.name_offset[r + 1] > records.name_offset[r] || old < 0) {
+                    updated.name_pool.append(records.names, records.name_offset[r], records.name_offset[r + 1] - records.name_offset[r]);
+                } else {
+                    const string_view name = netlist.name(old);
+                    updated.name_pool.append(name.data(), name.size());
+                }
+                for (uint32_t k = records.ref_offset[r]; k < records.ref_offset[r + 1]; ++k) {
+                    updated.fanin.push_back(-1 - records.ref_ids[k]);
+                    updated.fanin_pin.push_back(records.ref_pins[k]);
+                }
+                if (updated.ops[node] == OP_INPT) {
+                    updated.prob_0[node] = 0.25; // Probabilidades padrão das entradas, como no parser
+                    updated.prob_1[node] = 0.25;
+                }
+                changed.push_back(node);
+            }
+            updated.name_offset.push_back(updated.name_pool.size());
+            updated.fanin_offset.push_back(updated.fanin.size());
+        }
+
+        // Conexões: índices antigos (>= 0) são remapeados; IDs de elementos redefinidos (codificados como -1 - ID) são buscados
+        for (int node = 0; node < n; ++node) {
+            for (uint32_t k = updated.fanin_offset[node]; k < updated.fanin_offset[node + 1]; ++k) {
+                const int ref = updated.fanin[k];
+                const int source = ref >= 0 ? old_to_new[ref] : findNode(updated.ids, -1 - ref);
+                if (source < 0) {
+                    const int source_id = ref >= 0 ? netlist.ids[ref] : -1 - ref;
+                    throw runtime_error("Element " + to_string(updated.ids[node]) + " references undefined element " + to_string(source_id));
+                }
+                updated.fanin[k] = source;
+            }
+        }
+
+        // Macros: as da netlist vêm primeiro em delta.elements.macros, então as instâncias mantidas conservam o índice;
+        // as instâncias do delta usam o índice resolvido pelo parser (macros da netlist ou declaradas no delta)
+        updated.macros = delta.elements.macros.empty() ? netlist.macros : delta.elements.macros;
+        if (!updated.macros.empty()) {
+            updated.macro_index.assign(n, 0);
+            for (int old = 0; old < old_n; ++old) {
+                const int node = old_to_new[old];
+                if (node >= 0 && updated.ops[node] == OP_MACRO && netlist.ops[old] == OP_MACRO) updated.macro_index[node] = netlist.macro_index[old];
+            }
+            for (const auto& [r, macro] : delta.elements.macro_instances) {
+                if (record_by_id[delta.elements.ids[r]] == (int)r) updated.macro_index[findNode(updated.ids, delta.elements.ids[r])] = macro;
+            }
+        }
+
+        // Pinos extras: os elementos mantidos com o mesmo tipo conservam as probabilidades dos seus pinos
+        assignOutputPins(updated);
+        for (int old = 0; old < old_n; ++old) {
+            const int node = old_to_new[old];
+            if (node < 0 || updated.ops[node] != netlist.ops[old]) continue;
+            const uint32_t from = netlist.pin_offset[old], to = updated.pin_offset[node];
+            for (uint32_t k = 0; k < netlist.pin_offset[old + 1] - from; ++k) {
+                updated.pin_prob_0[to + k] = netlist.pin_prob_0[from + k];
+                updated.pin_prob_1[to + k] = netlist.pin_prob_1[from + k];
+            }
+        }
+
+        levelizeNetlist(updated);
+        applyInputProbabilities(updated);
+        netlist = move(updated);
+    } else {
+        applyInputProbabilities(netlist);
+    }
+
+    return propagateFanoutCone(netlist, changed);
+}
+
+
+
+
+
+// Vetor SIMD de cenários usado na propagação em lote (AVX-512, AVX2 ou escalar, conforme a compilação)
+#if defined(__AVX512F__)
+struct LaneVec {
+    __m512d v;
+    static constexpr size_t width = 8;
+    static LaneVec load(const double* p) { return {_mm512_loadu_pd(p)}; }
+    void store(double* p) const { _mm512_storeu_pd(p, v); }
+};
+inline LaneVec operator+(LaneVec a, LaneVec b) { return {_mm512_add_pd(a.v, b.v)}; }
+inline LaneVec operator-(LaneVec a, LaneVec b) { return {_mm512_sub_pd(a.v, b.v)}; }
+inline LaneVec operator*(LaneVec a, LaneVec b) { return {_mm512_mul_pd(a.v, b.v)}; }
+#elif defined(__AVX2__)
+struct LaneVec {
+    __m256d v;
+    static constexpr size_t width = 4;
+    static LaneVec load(const double* p) { return {_mm256_loadu_pd(p)}; }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+};
+inline LaneVec operator+(LaneVec a, LaneVec b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline LaneVec operator-(LaneVec a, LaneVec b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline LaneVec operator*(LaneVec a, LaneVec b) { return {_mm256_mul_pd(a.v, b.v)}; }
+#else
+struct LaneVec {
+    double v;
+    static constexpr size_t width = 1;
+    static LaneVec load(const double* p) { return {*p}; }
+    void store(double* p) const { *p = v; }
+};
+inline LaneVec operator+(LaneVec a, LaneVec b) { return {a.v + b.v}; }
+inline LaneVec operator-(LaneVec a, LaneVec b) { return {a.v - b.v}; }
+inline LaneVec operator*(LaneVec a, LaneVec b) { return {a.v * b.v}; }
+#endif
+
+// Probabilidades de K cenários para todos os nós da netlist
+// Layout: [nó * lanes + cenário]; 'lanes' é K arredondado para múltiplo da largura SIMD
+struct ScenarioBatch {
+    size_t scenarios = 0;
+    size_t lanes = 0;
+    vector<string> names;        // Nome de cada cenário (opcional, ex: perfis de entrada)
+    vector<double> prob_0;
+    vector<double> prob_1;
+    vector<double> pin_prob_0;   // Pinos extras: [Netlist::pin_offset[nó] + pino - 2) * lanes + cenário]
+    vector<double> pin_prob_1;
+
+    double* p0(int node) { return prob_0.data() + node * lanes; }
+    double* p1(int node) { return prob_1.data() + node * lanes; }
+    const double* p0(int node) const { return prob_0.data() + node * lanes; }
+    const double* p1(int node) const { return prob_1.data() + node * lanes; }
+};
+
+// Cria um lote com K cenários, todos inicializados com as probabilidades atuais da netlist
+ScenarioBatch createScenarioBatch(const Netlist& netlist, size_t scenarios) {
+    ScenarioBatch batch;
+    batch.scenarios = scenarios;
+    batch.lanes = (scenarios + LaneVec::width - 1) / LaneVec::width * LaneVec::width;
+    const size_t total = netlist.size() * batch.lanes;
+    batch.prob_0.resize(total);
+    batch.prob_1.resize(total);
+    batch.pin_prob_0.assign(netlist.pin_prob_0.size() * batch.lanes, 1.0);
+    batch.pin_prob_1.assign(netlist.pin_prob_1.size() * batch.lanes, 1.0);
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        fill_n(batch.p0(node), batch.lanes, netlist.prob_0[node]);
+        fill_n(batch.p1(node), batch.lanes, netlist.prob_1[node]);
+    }
+    return batch;
+}
+
+// Propaga todos os cenários do lote de uma vez: a travessia da netlist é feita uma única vez
+// e cada nó é avaliado para LaneVec::width cenários por instrução
+void calculateProbabilitiesBatch(const Netlist& netlist, ScenarioBatch& batch) {
+    ScopedTimer timer("propagate_batch");
+    const size_t lanes = batch.lanes;
+    for (int node : netlist.topo_order) {
+        for (size_t k = 0; k < lanes; k += LaneVec::width) {
+            auto load = [&](int source, int slot) {
+                if (slot < 0) {
+                    const size_t offset = source * lanes + k;
+                    return ProbPair<LaneVec>{LaneVec::load(&batch.prob_0[offset]), LaneVec::load(&batch.prob_1[offset])};
+                }
+                const size_t offset = slot * lanes + k;
+                return ProbPair<LaneVec>{LaneVec::load(&batch.pin_prob_0[offset]), LaneVec::load(&batch.pin_prob_1[offset])};
+            };
+
+            ProbPair<LaneVec> out{}, pins[MAX_EXTRA_PINS];
+            if (!evaluateNode(netlist, node, load, out, pins)) break;
+
+            const size_t offset = node * lanes + k;
+            out.p0.store(&batch.prob_0[offset]);
+            out.p1.store(&batch.prob_1[offset]);
+            for (uint32_t slot = netlist.pin_offset[node], p = 0; slot < netlist.pin_offset[node + 1]; ++slot, ++p) {
+                pins[p].p0.store(&batch.pin_prob_0[slot * lanes + k]);
+                pins[p].p1.store(&batch.pin_prob_1[slot * lanes + k]);
+            }
+        }
+    }
+    countEvaluatedGates(netlist, netlist.topo_order);
+}
+
+
+
+
+
+// Motor exato: os sinais são representados em dual-rail (t = "o sinal vale 1", f = "o sinal vale 0"; ambos falsos = nulo),
+// o que reproduz exatamente o modelo de probabilidades das fórmulas (P(0) + P(1) pode ser menor que 1).
+// Cada entrada usa duas variáveis booleanas independentes: d ("definida", P(0) + P(1)) e v ("vale 1 se definida").
+
+// Exceção lançada quando o BDD excede o orçamento de nós
+struct BddBudgetExceeded : runtime_error {
+    BddBudgetExceeded() : runtime_error("BDD node budget exceeded") {}
+};
+
+// Pacote de BDDs reduzidos e ordenados (ROBDD) com arestas complementadas
+// Uma aresta é (índice do nó << 1) | complemento; o nó 0 é o terminal, logo ONE = 0 e ZERO = 1.
+// Forma canônica: a aresta "high" nunca é complementada.
+class BddManager {
+public:
+    static constexpr uint32_t ONE = 0;
+    static constexpr uint32_t ZERO = 1;
+
+    BddManager(uint32_t num_vars, size_t node_budget) : num_vars(num_vars), node_budget(node_budget) {
+        nodes.push_back({num_vars, ONE, ONE}); // Terminal: variável "depois de todas"
+        unique.assign(1 << 16, 0);
+        cache.assign(1 << 18, CacheEntry{0, 0, 0, 0});
+    }
+
+    static uint32_t bddNot(uint32_t f) { return f ^ 1; }
+
+    uint32_t var(uint32_t v) { return makeNode(v, ZERO, ONE); }
+
+    uint32_t bddAnd(uint32_t f, uint32_t g) {
+        if (f == ZERO || g == ZERO || f == bddNot(g)) return ZERO;
+        if (f == ONE || f == g) return g;
+        if (g == ONE) return f;
+        if (f > g) swap(f, g);
+
+        CacheEntry& entry = cache[cacheSlot(OP_CACHE_AND, f, g)];
+        if (entry.op == OP_CACHE_AND && entry.f == f && entry.g == g) return entry.result;
+
+        const uint32_t v = min(topVar(f), topVar(g));
+        uint32_t f0, f1, g0, g1;
+        cofactors(f, v, f0, f1);
+        cofactors(g, v, g0, g1);
+        const uint32_t low = bddAnd(f0, g0);
+        const uint32_t high = bddAnd(f1, g1);
+        const uint32_t result = makeNode(v, low, high);
+
+        // A referência 'entry' pode ter sido sobrescrita pela recursão, mas continua válida (cache de tamanho fixo)
+        entry = {OP_CACHE_AND, f, g, result};
+        return result;
+    }
+
+    uint32_t bddOr(uint32_t f, uint32_t g) { return bddNot(bddAnd(bddNot(f), bddNot(g))); }
+
+    uint32_t bddXor(uint32_t f, uint32_t g) {
+        // xor(~f, g) = ~xor(f, g): os complementos são retirados e reaplicados no resultado
+        const uint32_t complement = (f ^ g) & 1;
+        f &= ~1u;
+        g &= ~1u;
+        if (f == g) return ZERO ^ complement;
+        if (f == ONE) return bddNot(g) ^ complement;
+        if (g == ONE) return bddNot(f) ^ complement;
+        if (f > g) swap(f, g);
+
+        CacheEntry& entry = cache[cacheSlot(OP_CACHE_XOR, f, g)];
+        if (entry.op == OP_CACHE_XOR && entry.f == f && entry.g == g) return entry.result ^ complement;
+
+        const uint32_t v = min(topVar(f), topVar(g));
+        uint32_t f0, f1, g0, g1;
+        cofactors(f, v, f0, f1);
+        cofactors(g, v, g0, g1);
+        const uint32_t low = bddXor(f0, g0);
+        const uint32_t high = bddXor(f1, g1);
+        const uint32_t result = makeNode(v, low, high);
+
+        entry = {OP_CACHE_XOR, f, g, result};
+        return result ^ complement;
+    }
+
+    // Probabilidade de a função valer 1, com variáveis independentes de probabilidades var_prob;
+    // a memória de resultados por nó é compartilhada entre chamadas (uma única travessia ponderada para todas as raízes)
+    double probability(uint32_t f, const vector<double>& var_prob) {
+        if (memo.size() < nodes.size()) memo.resize(nodes.size(), -1.0);
+        const double p = nodeProbability(f >> 1, var_prob);
+        return (f & 1) ? 1.0 - p : p;
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Node {
+        uint32_t var;
+        uint32_t low;
+        uint32_t high;
+    };
+
+    struct CacheEntry {
+        uint32_t op;
+        uint32_t f;
+        uint32_t g;
+        uint32_t result;
+    };
+
+    static constexpr uint32_t OP_CACHE_AND = 1;
+    static constexpr uint32_t OP_CACHE_XOR = 2;
+
+    uint32_t num_vars;
+    size_t node_budget;
+    vector<Node> nodes;
+    vector<uint32_t> unique;    // Tabela única (endereçamento aberto); 0 indica posição vazia
+    vector<CacheEntry> cache;   // Tabela de resultados calculados (mapeamento direto)
+    vector<double> memo;
+
+    static uint64_t hashTriple(uint32_t a, uint32_t b, uint32_t c) {
+        uint64_t h = a * 0x9E3779B97F4A7C15ull;
+        h ^= (b + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2));
+        h ^= (c * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2));
+        return h ^ (h >> 29);
+    }
+
+    size_t cacheSlot(uint32_t op, uint32_t f, uint32_t g) const { return hashTriple(op, f, g) & (cache.size() - 1); }
+
+    uint32_t topVar(uint32_t f) const { return nodes[f >> 1].var; }
+
+    void cofactors(uint32_t f, uint32_t v, uint32_t& f0, uint32_t& f1) const {
+        const Node& node = nodes[f >> 1];
+        if (node.var != v) {
+            f0 = f1 = f;
+        } else {
+            f0 = node.low ^ (f & 1);
+            f1 = node.high ^ (f & 1);
+        }
+    }
+
+    uint32_t makeNode(uint32_t v, uint32_t low, uint32_t high) {
+        if (low == high) return low;
+        if (high & 1) return makeNode(v, bddNot(low), bddNot(high)) ^ 1;
+
+        size_t mask = unique.size() - 1;
+        size_t slot = hashTriple(v, low, high) & mask;
+        while (unique[slot] != 0) {
+            const Node& node = nodes[unique[slot]];
+            if (node.var == v && node.low == low && node.high == high) return unique[slot] << 1;
+            slot = (slot + 1) & mask;
+        }
+
+        if (nodes.size() >= node_budget) throw BddBudgetExceeded();
+        const uint32_t index = nodes.size();
+        nodes.push_back({v, low, high});
+        unique[slot] = index;
+
+        // Mantém a tabela única com fator de carga de no máximo 1/2
+        if (nodes.size() * 2 > unique.size()) {
+            vector<uint32_t> old(unique.size() * 2, 0);
+            old.swap(unique);
+            mask = unique.size() - 1;
+            for (uint32_t entry : old) {
+                if (entry == 0) continue;
+                const Node& node = nodes[entry];
+                size_t s = hashTriple(node.var, node.low, node.high) & mask;
+                while (unique[s] != 0) s = (s + 1) & mask;
+                unique[s] = entry;
+            }
+        }
+        return index << 1;
+    }
+
+    double nodeProbability(uint32_t index, const vector<double>& var_prob) {
+        if (index == 0) return 1.0;
+        if (memo[index] >= 0.0) return memo[index];
+        const Node& node = nodes[index];
+        const double p_low = (node.low & 1) ? 1.0 - nodeProbability(node.low >> 1, var_prob) : nodeProbability(node.low >> 1, var_prob);
+        const double p_high = nodeProbability(node.high >> 1, var_prob);
+        const double p = var_prob[node.var];
+        return memo[index] = (1.0 - p) * p_low + p * p_high;
+    }
+};
+
+// Sinal dual-rail representado por dois BDDs
+struct BddSignal {
+    BddManager* manager;
+    uint32_t t;
+    uint32_t f;
+};
+
+inline BddSignal probNot(const BddSignal& x) {
+    return {x.manager, x.f, x.t};
+}
+
+inline BddSignal probAnd(const BddSignal& x, const BddSignal& y) {
+    return {x.manager, x.manager->bddAnd(x.t, y.t), x.manager->bddOr(x.f, y.f)};
+}
+
+inline BddSignal probOr(const BddSignal& x, const BddSignal& y) {
+    return {x.manager, x.manager->bddOr(x.t, y.t), x.manager->bddAnd(x.f, y.f)};
+}
+
+inline BddSignal probXor(const BddSignal& x, const BddSignal& y) {
+    BddManager& m = *x.manager;
+    return {x.manager, m.bddOr(m.bddAnd(x.t, y.f), m.bddAnd(x.f, y.t)), m.bddOr(m.bddAnd(x.f, y.f), m.bddAnd(x.t, y.t))};
+}
+
+// Ordenação estática das variáveis do BDD
+enum BddOrdering : uint8_t {
+    BDD_ORDER_DFS, // Entradas na ordem em que são alcançadas por uma busca em profundidade a partir das saídas
+    BDD_ORDER_ID   // Entradas em ordem crescente de ID
+};
+
+struct ExactOptions {
+    unsigned exhaustive_max_vars = 24; // Limite de variáveis para a tabela-verdade exaustiva (2^24 mintermos)
+    size_t bdd_node_budget = 1 << 22;
+    BddOrdering ordering = BDD_ORDER_DFS;
+};
+
+
+
+
+
+// Função para ordenar as entradas da netlist para o BDD
+vector<int> orderInputsForBdd(const Netlist& netlist, BddOrdering ordering) {
+    const int n = netlist.size();
+    vector<int> order;
+    vector<char> visited(n, 0);
+
+    if (ordering == BDD_ORDER_DFS) {
+        // Busca em profundidade a partir de cada saída, seguindo as entradas de cada nó na ordem do arquivo
+        vector<pair<int, uint32_t>> stack;
+        for (int output = 0; output < n; ++output) {
+            if (netlist.ops[output] != OP_OUT || visited[output]) continue;
+            visited[output] = 1;
+            stack.push_back({output, 0});
+            while (!stack.empty()) {
+                auto& [node, next_input] = stack.back();
+                if (next_input == netlist.faninCount(node)) {
+                    if (netlist.ops[node] == OP_INPT) order.push_back(node);
+                    stack.pop_back();
+                    continue;
+                }
+                const int source = netlist.faninBegin(node)[next_input++];
+                if (!visited[source]) {
+                    visited[source] = 1;
+                    stack.push_back({source, 0});
+                }
+            }
+        }
+    }
+
+    // Entradas restantes (ou todas, na ordenação por ID) em ordem crescente de ID
+    for (int node = 0; node < n; ++node) {
+        if (netlist.ops[node] == OP_INPT && !visited[node]) order.push_back(node);
+    }
+    return order;
+}
+
+
+
+
+
+// Função para calcular as probabilidades exatas (sem supor independência entre as entradas das portas) com BDDs
+// Retorna false, sem alterar a netlist, quando o orçamento de nós é excedido ou a netlist tem elementos não suportados
+bool calculateBddProbabilities(Netlist& netlist, const ExactOptions& options) {
+    const int n = netlist.size();
+    const vector<int> inputs = orderInputsForBdd(netlist, options.ordering);
+
+    BddManager manager(2 * inputs.size(), options.bdd_node_budget);
+    vector<double> var_prob(2 * inputs.size());
+    vector<BddSignal> signal(n, BddSignal{&manager, BddManager::ZERO, BddManager::ZERO});
+    vector<BddSignal> pin_signal(netlist.pin_prob_0.size(), BddSignal{&manager, BddManager::ZERO, BddManager::ZERO});
+
+    try {
+        for (size_t rank = 0; rank < inputs.size(); ++rank) {
+            const int node = inputs[rank];
+            const double defined = netlist.prob_0[node] + netlist.prob_1[node];
+            if (defined > 1.0 + 1e-12) {
+                cerr << "Warning: Input " << netlist.ids[node] << " has P(0) + P(1) > 1; exact mode unavailable" << endl;
+                return false;
+            }
+            var_prob[2 * rank] = min(defined, 1.0);
+            var_prob[2 * rank + 1] = defined > 0.0 ? netlist.prob_1[node] / defined : 0.5;
+
+            const uint32_t d = manager.var(2 * rank);
+            const uint32_t v = manager.var(2 * rank + 1);
+            signal[node] = {&manager, manager.bddAnd(d, v), manager.bddAnd(d, BddManager::bddNot(v))};
+        }
+
+        auto load = [&](int source, int slot) { return slot < 0 ? signal[source] : pin_signal[slot]; };
+        for (int node : netlist.topo_order) {
+            if (netlist.ops[node] == OP_INPT) continue;
+            if (!evaluateNode(netlist, node, load, signal[node], pin_signal.data() + netlist.pin_offset[node])) {
+                cerr << "Warning: Element " << netlist.ids[node] << " (" << OP_NAMES[netlist.ops[node]]
+                     << ") cannot be evaluated exactly; exact mode unavailable" << endl;
+                return false;
+            }
+        }
+    } catch (const BddBudgetExceeded&) {
+        cerr << "Warning: BDD node budget (" << options.bdd_node_budget << ") exceeded; keeping the independent approximation" << endl;
+        return false;
+    }
+
+    // Travessia ponderada: uma probabilidade por raiz, com memória compartilhada entre todas as raízes
+    for (int node = 0; node < n; ++node) {
+        netlist.prob_1[node] = manager.probability(signal[node].t, var_prob);
+        netlist.prob_0[node] = manager.probability(signal[node].f, var_prob);
+    }
+    for (size_t slot = 0; slot < pin_signal.size(); ++slot) {
+        netlist.pin_prob_1[slot] = manager.probability(pin_signal[slot].t, var_prob);
+        netlist.pin_prob_0[slot] = manager.probability(pin_signal[slot].f, var_prob);
+    }
+    return true;
+}
+
+
+
+
+
+// Bloco de amostras da simulação bit-paralela: 64 amostras por palavra, SIM_WORDS palavras por bloco
+// (8 palavras = 512 bits com AVX-512, 4 = 256 bits com AVX2); as operações são laços simples vetorizados pelo compilador
+#if defined(__AVX512F__)
+constexpr size_t SIM_WORDS = 8;
+#elif defined(__AVX2__)
+constexpr size_t SIM_WORDS = 4;
+#else
+constexpr size_t SIM_WORDS = 1;
+#endif
+
+struct SimWord {
+    uint64_t w[SIM_WORDS];
+};
+
+inline SimWord operator&(const SimWord& a, const SimWord& b) {
+    SimWord r;
+    for (size_t i = 0; i < SIM_WORDS; ++i) r.w[i] = a.w[i] & b.w[i];
+    return r;
+}
+
+inline SimWord operator|(const SimWord& a, const SimWord& b) {
+    SimWord r;
+    for (size_t i = 0; i < SIM_WORDS; ++i) r.w[i] = a.w[i] | b.w[i];
+    return r;
+}
+
+inline uint64_t popcount(const SimWord& a) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < SIM_WORDS; ++i) count += __builtin_popcountll(a.w[i]);
+    return count;
+}
+
+// Sinal dual-rail bit-paralelo: cada bit é uma amostra (t = vale 1, f = vale 0, ambos zerados = nulo)
+template <class W>
+struct DualRail {
+    W t;
+    W f;
+};
+
+template <class W>
+inline DualRail<W> probNot(const DualRail<W>& x) {
+    return {x.f, x.t};
+}
+
+template <class W>
+inline DualRail<W> probAnd(const DualRail<W>& x, const DualRail<W>& y) {
+    return {x.t & y.t, x.f | y.f};
+}
+
+template <class W>
+inline DualRail<W> probOr(const DualRail<W>& x, const DualRail<W>& y) {
+    return {x.t | y.t, x.f & y.f};
+}
+
+template <class W>
+inline DualRail<W> probXor(const DualRail<W>& x, const DualRail<W>& y) {
+    return {(x.t & y.f) | (x.f & y.t), (x.f & y.f) | (x.t & y.t)};
+}
+
+// Gerador aleatório baseado em contador: o valor depende apenas de (semente, fluxo, contador),
+// então qualquer divisão do trabalho entre threads produz exatamente as mesmas amostras
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Hash do tipo de um nó para os hashes estruturais; instâncias de macros diferentes não se confundem
+inline uint64_t nodeTypeHash(const Netlist& netlist, int node) {
+    const uint64_t h = mix64(netlist.ops[node] + 1);
+    return netlist.ops[node] == OP_MACRO ? h ^ netlist.macros[netlist.macro_index[node]]->signature : h;
+}
+
+inline uint64_t counterRandom(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return mix64(mix64(seed + 0x9E3779B97F4A7C15ull * (stream + 1)) ^ counter);
+}
+
+// Palavra de 64 amostras de Bernoulli(p) a partir dos bits de p (32 bits de precisão): cada palavra aleatória
+// é combinada com OR (bit 1) ou AND (bit 0), do bit menos significativo ao mais significativo
+inline uint64_t bernoulliWord(double p, uint64_t seed, uint64_t stream, uint64_t word_index) {
+    const uint64_t threshold = (uint64_t)llround(min(max(p, 0.0), 1.0) * 4294967296.0);
+    if (threshold == 0) return 0;
+    if (threshold >= 4294967296ull) return ~0ull;
+    uint64_t result = 0;
+    for (int bit = __builtin_ctzll(threshold); bit < 32; ++bit) {
+        const uint64_t r = counterRandom(seed, stream, word_index * 32 + bit);
+        result = ((threshold >> bit) & 1) ? (result | r) : (result & r);
+    }
+    return result;
+}
+
+// Contagens de amostras em 0 e em 1 de cada nó (e do carry-out dos sum_sub)
+struct MonteCarloResult {
+    uint64_t samples = 0;
+    vector<uint64_t> count_0;
+    vector<uint64_t> count_1;
+    vector<uint64_t> pin_count_0;    // Pinos extras, indexados como Netlist::pin_prob_*
+    vector<uint64_t> pin_count_1;
+};
+
+// Intervalo de confiança de Wilson (95%) para uma proporção
+inline pair<double, double> wilsonInterval(uint64_t successes, uint64_t samples) {
+    if (samples == 0) return {0.0, 1.0};
+    const double z = 1.959963984540054;
+    const double n = samples;
+    const double p = successes / n;
+    const double denominator = 1.0 + z * z / n;
+    const double center = (p + z * z / (2.0 * n)) / denominator;
+    const double half = z * sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denominator;
+    return {max(0.0, center - half), min(1.0, center + half)};
+}
+
+
+
+
+
+// Função para estimar P(0)/P(1) de todos os nós por simulação lógica bit-paralela (Monte Carlo)
+// As amostras são arredondadas para múltiplos de 64 * SIM_WORDS; cada thread processa um intervalo de blocos
+// Retorna false quando a netlist tem elementos não suportados ou entradas com P(0) + P(1) > 1
+bool simulateMonteCarlo(const Netlist& netlist, uint64_t samples, uint64_t seed, unsigned num_threads, MonteCarloResult& result) {
+    ScopedTimer timer("monte_carlo");
+    const int n = netlist.size();
+    const size_t pins = netlist.pin_prob_0.size();
+    const uint64_t block_bits = 64 * SIM_WORDS;
+    const uint64_t blocks = (samples + block_bits - 1) / block_bits;
+
+    // Probabilidades das entradas: t ~ Bernoulli(P(1)); f ~ Bernoulli(P(0) / (1 - P(1))) entre as amostras em que t = 0
+    vector<int> inputs;
+    vector<double> prob_t, prob_f_given_not_t;
+    for (int node = 0; node < n; ++node) {
+        if (netlist.ops[node] != OP_INPT) continue;
+        const double p0 = netlist.prob_0[node], p1 = netlist.prob_1[node];
+        if (p0 + p1 > 1.0 + 1e-12) {
+            cerr << "Warning: Input " << netlist.ids[node] << " has P(0) + P(1) > 1; Monte Carlo unavailable" << endl;
+            return false;
+        }
+        inputs.push_back(node);
+        prob_t.push_back(p1);
+        prob_f_given_not_t.push_back(p1 < 1.0 ? min(1.0, p0 / (1.0 - p1)) : 0.0);
+    }
+    for (int node : netlist.topo_order) {
+        if (netlist.ops[node] != OP_INPT && !canEvaluateNode(netlist, node)) {
+            cerr << "Warning: Element " << netlist.ids[node] << " (" << OP_NAMES[netlist.ops[node]]
+                 << ") cannot be simulated; Monte Carlo unavailable" << endl;
+            return false;
+        }
+    }
+
+    num_threads = max(1u, min<unsigned>(num_threads, max<uint64_t>(blocks, 1)));
+    vector<MonteCarloResult> partial(num_threads);
+
+    auto worker = [&](unsigned thread_index) {
+        MonteCarloResult& local = partial[thread_index];
+        local.count_0.assign(n, 0);
+        local.count_1.assign(n, 0);
+        local.pin_count_0.assign(pins, 0);
+        local.pin_count_1.assign(pins, 0);
+        vector<DualRail<SimWord>> signal(n), pin_signal(pins);
+        auto load = [&](int source, int slot) { return slot < 0 ? signal[source] : pin_signal[slot]; };
+
+        const uint64_t first = blocks * thread_index / num_threads;
+        const uint64_t last = blocks * (thread_index + 1) / num_threads;
+        for (uint64_t block = first; block < last; ++block) {
+            // Amostras das entradas; os bits além de 'samples' no último bloco são zerados (sinal nulo, não contados)
+            for (size_t k = 0; k < inputs.size(); ++k) {
+                DualRail<SimWord>& s = signal[inputs[k]];
+                for (size_t i = 0; i < SIM_WORDS; ++i) {
+                    const uint64_t word_index = block * SIM_WORDS + i;
+                    const uint64_t t = bernoulliWord(prob_t[k], seed, 2 * k, word_index);
+                    const uint64_t f = ~t & bernoulliWord(prob_f_given_not_t[k], seed, 2 * k + 1, word_index);
+                    s.t.w[i] = t;
+                    s.f.w[i] = f;
+                }
+            }
+
+            SimWord valid;
+            for (size_t i = 0; i < SIM_WORDS; ++i) {
+                const uint64_t bit_begin = (block * SIM_WORDS + i) * 64;
+                valid.w[i] = bit_begin + 64 <= samples ? ~0ull : bit_begin >= samples ? 0ull : (1ull << (samples - bit_begin)) - 1;
+            }
+
+            for (int node : netlist.topo_order) {
+                if (netlist.ops[node] != OP_INPT) {
+                    evaluateNode(netlist, node, load, signal[node], pin_signal.data() + netlist.pin_offset[node]);
+                }
+                local.count_1[node] += popcount(signal[node].t & valid);
+                local.count_0[node] += popcount(signal[node].f & valid);
+                for (uint32_t slot = netlist.pin_offset[node]; slot < netlist.pin_offset[node + 1]; ++slot) {
+                    local.pin_count_1[slot] += popcount(pin_signal[slot].t & valid);
+                    local.pin_count_0[slot] += popcount(pin_signal[slot].f & valid);
+                }
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < num_threads; ++t) threads.emplace_back(worker, t);
+    worker(0);
+    for (auto& t : threads) t.join();
+
+    // Soma das contagens parciais de cada thread
+    result.samples = samples;
+    result.count_0.assign(n, 0);
+    result.count_1.assign(n, 0);
+    result.pin_count_0.assign(pins, 0);
+    result.pin_count_1.assign(pins, 0);
+    for (const auto& local : partial) {
+        for (int node = 0; node < n; ++node) {
+            result.count_0[node] += local.count_0[node];
+            result.count_1[node] += local.count_1[node];
+        }
+        for (size_t slot = 0; slot < pins; ++slot) {
+            result.pin_count_0[slot] += local.pin_count_0[slot];
+            result.pin_count_1[slot] += local.pin_count_1[slot];
+        }
+    }
+    return true;
+}
+
+
+
+
+
+// Padrões de bits das 6 variáveis menos significativas dentro de uma palavra de 64 mintermos
+constexpr uint64_t TRUTH_TABLE_PATTERNS[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+};
+
+// Função para calcular as probabilidades exatas enumerando todos os mintermos das variáveis de entrada (tabela-verdade)
+// Cada entrada usa até duas variáveis (definida/valor, como no BDD); entradas binárias usam só uma e entradas nulas nenhuma
+// A probabilidade de um nó é a soma dos pesos dos mintermos em que ele vale 0/1: o peso de um mintermo é o produto
+// do peso das variáveis altas (por palavra) pela soma dos pesos das 6 variáveis baixas (por bit, via tabelas de bytes)
+// Retorna false, sem alterar a netlist e sem avisos, quando há mais de max_vars variáveis ou a netlist não é suportada
+// (o BDD, usado em seguida, relata o motivo)
+bool calculateExhaustiveProbabilities(Netlist& netlist, unsigned max_vars) {
+    const int n = netlist.size();
+
+    // Variáveis de cada entrada: d (definida) com P(0) + P(1) e v (valor) com P(1) / (P(0) + P(1))
+    vector<int> inputs, input_d, input_v;
+    vector<double> var_prob;
+    for (int node = 0; node < n; ++node) {
+        if (netlist.ops[node] != OP_INPT) continue;
+        const double defined = netlist.prob_0[node] + netlist.prob_1[node];
+        if (defined > 1.0 + 1e-12) return false;
+        int d = -1, v = -1;
+        if (defined > 0.0) {
+            if (defined < 1.0 - 1e-12) {
+                d = var_prob.size();
+                var_prob.push_back(defined);
+            }
+            v = var_prob.size();
+            var_prob.push_back(netlist.prob_1[node] / defined);
+        }
+        inputs.push_back(node);
+        input_d.push_back(d);
+        input_v.push_back(v);
+    }
+    if (var_prob.size() > max_vars) return false;
+    for (int node : netlist.topo_order) {
+        if (netlist.ops[node] != OP_INPT && !canEvaluateNode(netlist, node)) return false;
+    }
+
+    // Variáveis fictícias (P = 0) completam as 6 variáveis baixas: mintermos com elas em 1 têm peso zero
+    const unsigned num_vars = max<size_t>(var_prob.size(), 6);
+    var_prob.resize(num_vars, 0.0);
+    const uint64_t num_words = 1ull << (num_vars - 6);
+
+    // Soma dos pesos das variáveis baixas para cada byte de cada posição da palavra
+    double byte_weight[8][256];
+    for (int position = 0; position < 8; ++position) {
+        for (int value = 0; value < 256; ++value) {
+            double sum = 0.0;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (!((value >> bit) & 1)) continue;
+                const int minterm = 8 * position + bit;
+                double weight = 1.0;
+                for (int var = 0; var < 6; ++var) weight *= ((minterm >> var) & 1) ? var_prob[var] : 1.0 - var_prob[var];
+                sum += weight;
+            }
+            byte_weight[position][value] = sum;
+        }
+    }
+
+    // Peso das variáveis altas de cada palavra, construído dobrando a tabela a cada variável
+    vector<double> word_weight(1, 1.0);
+    word_weight.reserve(num_words);
+    for (unsigned var = 6; var < num_vars; ++var) {
+        const size_t half = word_weight.size();
+        word_weight.resize(2 * half);
+        for (size_t i = 0; i < half; ++i) {
+            word_weight[half + i] = word_weight[i] * var_prob[var];
+            word_weight[i] *= 1.0 - var_prob[var];
+        }
+    }
+
+    auto mintermWeight = [&](uint64_t bits) {
+        double sum = 0.0;
+        for (int position = 0; position < 8; ++position) sum += byte_weight[position][(bits >> (8 * position)) & 0xFF];
+        return sum;
+    };
+
+    const size_t pins = netlist.pin_prob_0.size();
+    vector<double> sum_0(n, 0.0), sum_1(n, 0.0), pin_sum_0(pins, 0.0), pin_sum_1(pins, 0.0);
+    vector<DualRail<SimWord>> signal(n), pin_signal(pins);
+    auto load = [&](int source, int slot) { return slot < 0 ? signal[source] : pin_signal[slot]; };
+
+    auto variableWord = [&](int var, uint64_t word_index) -> uint64_t {
+        if (var < 6) return TRUTH_TABLE_PATTERNS[var];
+        return ((word_index >> (var - 6)) & 1) ? ~0ull : 0ull;
+    };
+
+    // Blocos de SIM_WORDS palavras; as palavras além de num_words no último bloco são zeradas (sinal nulo, peso zero)
+    for (uint64_t first_word = 0; first_word < num_words; first_word += SIM_WORDS) {
+        for (size_t k = 0; k < inputs.size(); ++k) {
+            DualRail<SimWord>& s = signal[inputs[k]];
+            for (size_t i = 0; i < SIM_WORDS; ++i) {
+                const uint64_t word_index = first_word + i;
+                uint64_t d = ~0ull, v = 0;
+                if (input_v[k] < 0 || word_index >= num_words) {
+                    d = 0;
+                } else {
+                    if (input_d[k] >= 0) d = variableWord(input_d[k], word_index);
+                    v = variableWord(input_v[k], word_index);
+                }
+                s.t.w[i] = d & v;
+                s.f.w[i] = d & ~v;
+            }
+        }
+
+        for (int node : netlist.topo_order) {
+            if (netlist.ops[node] != OP_INPT) {
+                evaluateNode(netlist, node, load, signal[node], pin_signal.data() + netlist.pin_offset[node]);
+            }
+            for (size_t i = 0; i < SIM_WORDS && first_word + i < num_words; ++i) {
+                const double weight = word_weight[first_word + i];
+                sum_1[node] += weight * mintermWeight(signal[node].t.w[i]);
+                sum_0[node] += weight * mintermWeight(signal[node].f.w[i]);
+                for (uint32_t slot = netlist.pin_offset[node]; slot < netlist.pin_offset[node + 1]; ++slot) {
+                    pin_sum_1[slot] += weight * mintermWeight(pin_signal[slot].t.w[i]);
+                    pin_sum_0[slot] += weight * mintermWeight(pin_signal[slot].f.w[i]);
+                }
+            }
+        }
+    }
+
+    for (int node = 0; node < n; ++node) {
+        netlist.prob_0[node] = sum_0[node];
+        netlist.prob_1[node] = sum_1[node];
+    }
+    netlist.pin_prob_0 = move(pin_sum_0);
+    netlist.pin_prob_1 = move(pin_sum_1);
+    return true;
+}
+
+
+
+
+
+// Função para calcular as probabilidades exatas escolhendo o método pelo tamanho da netlist:
+// tabela-verdade exaustiva para poucas variáveis de entrada, BDD nos demais casos
+// Retorna false, mantendo a aproximação independente, quando nenhum método exato se aplica
+bool calculateExactProbabilities(Netlist& netlist, const ExactOptions& options) {
+    ScopedTimer timer("exact");
+    if (calculateExhaustiveProbabilities(netlist, options.exhaustive_max_vars)) return true;
+    return calculateBddProbabilities(netlist, options);
+}
+
+
+
+
+
+// Caminhos lógicos das saídas representados como DAG (o próprio grafo da netlist restrito aos cones das saídas)
+// Os caminhos nunca são materializados: path_count é calculado por programação dinâmica
+// e os caminhos são enumerados sob demanda pelo PathIterator
+struct PathDag {
+    vector<uint64_t> path_count;        // Caminhos de cada nó até as entradas (saturado em UINT64_MAX)
+    map<int, vector<int>> output_cones; // Nós do cone de cada saída, em ordem topológica
+};
+
+// Soma com saturação para contagens de caminhos
+inline uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+    const uint64_t sum = a + b;
+    return sum < a ? UINT64_MAX : sum;
+}
+
+
+
+
+
+// Iterador que produz os caminhos de uma saída um a um, na mesma ordem da enumeração recursiva
+// (saída -> entradas, seguindo as conexões na ordem do arquivo); ramos sem caminhos são podados
+class PathIterator {
+public:
+    PathIterator(const Netlist& netlist, const PathDag& dag, int output) : netlist(netlist), dag(dag) {
+        if (dag.path_count[output] > 0) {
+            stack.push_back({output, 0});
+            current.push_back(output);
+        }
+    }
+
+    // Avança para o próximo caminho; retorna false quando não há mais caminhos
+    bool next() {
+        // Descarta a entrada que encerrou o caminho anterior
+        if (emitted) {
+            stack.pop_back();
+            current.pop_back();
+            emitted = false;
+        }
+
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (netlist.ops[top.node] == OP_INPT) {
+                emitted = true;
+                return true;
+            }
+
+            const int* fanin = netlist.faninBegin(top.node);
+            const uint32_t count = pathFaninCount(netlist, top.node);
+            while (top.next_input < count && dag.path_count[fanin[top.next_input]] == 0) {
+                top.next_input++;
+            }
+
+            if (top.next_input == count) {
+                stack.pop_back();
+                current.pop_back();
+            } else {
+                const int child = fanin[top.next_input++];
+                stack.push_back({child, 0});
+                current.push_back(child);
+            }
+        }
+        return false;
+    }
+
+    // Caminho atual, da saída até a entrada (índices densos)
+    const vector<int>& path() const { return current; }
+
+private:
+    struct Frame {
+        int node;
+        uint32_t next_input;
+    };
+
+    const Netlist& netlist;
+    const PathDag& dag;
+    vector<Frame> stack;
+    vector<int> current;
+    bool emitted = false;
+};
+
+
+
+
+
+// Saídas (elementos "out") de uma netlist, em ordem de ID
+vector<int> listOutputs(const Netlist& netlist) {
+    vector<int> outputs;
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        if (netlist.ops[node] == OP_OUT) outputs.push_back(node);
+    }
+    return outputs;
+}
+
+// Função para construir o DAG de caminhos das saídas indicadas (todas quando 'outputs' é nulo)
+// As contagens de caminhos são calculadas para todos os nós em uma travessia linear; os cones, e portanto a
+// enumeração dos caminhos em displayOutputPaths, ficam restritos às saídas pedidas
+void findPathsForOutputs(const Netlist& netlist, PathDag& output_paths, const vector<int>* outputs = nullptr) {
+    ScopedTimer timer("paths");
+    const int n = netlist.size();
+
+    // Quantidade de caminhos de cada nó até as entradas, em ordem topológica
+    output_paths.path_count.assign(n, 0);
+    vector<int> topo_rank(n);
+    for (int k = 0; k < n; ++k) {
+        const int node = netlist.topo_order[k];
+        topo_rank[node] = k;
+        if (netlist.ops[node] == OP_INPT) {
+            output_paths.path_count[node] = 1;
+            continue;
+        }
+        const int* fanin = netlist.faninBegin(node);
+        const uint32_t count = pathFaninCount(netlist, node);
+        uint64_t paths = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            paths = saturatingAdd(paths, output_paths.path_count[fanin[i]]);
+        }
+        output_paths.path_count[node] = paths;
+    }
+
+    // Cone de cada saída: nós alcançáveis seguindo as conexões dos caminhos
+    output_paths.output_cones.clear();
+    vector<int> visited(n, -1);
+    vector<int> pending;
+    const vector<int> all_outputs = outputs ? vector<int>() : listOutputs(netlist);
+    for (int output : outputs ? *outputs : all_outputs) {
+        if (output_paths.output_cones.count(output)) continue;
+
+        vector<int>& cone = output_paths.output_cones[output];
+        pending.assign(1, output);
+        visited[output] = output;
+        while (!pending.empty()) {
+            const int node = pending.back();
+            pending.pop_back();
+            cone.push_back(node);
+            if (netlist.ops[node] == OP_INPT) continue;
+
+            const int* fanin = netlist.faninBegin(node);
+            const uint32_t count = pathFaninCount(netlist, node);
+            for (uint32_t i = 0; i < count; ++i) {
+                if (visited[fanin[i]] != output) {
+                    visited[fanin[i]] = output;
+                    pending.push_back(fanin[i]);
+                }
+            }
+        }
+        sort(cone.begin(), cone.end(), [&](int a, int b) { return topo_rank[a] < topo_rank[b]; });
+    }
+}
+
+
+
+
+
+// Estatísticas agregadas dos caminhos que partem de cada nó até as entradas, calculadas por programação dinâmica
+// O produto de um caminho multiplica as probabilidades de todos os seus elementos (carry-out quando o caminho
+// passa pelo pino ".2" de um sum_sub); os extremos não incluem o fator do próprio nó, que depende do pino lido
+struct PathStats {
+    vector<double> path_count;       // Quantidade de caminhos em ponto flutuante (não satura)
+    vector<uint32_t> shortest;       // Menor quantidade de elementos em um caminho até uma entrada
+    vector<uint32_t> longest;        // Maior quantidade de elementos em um caminho até uma entrada
+    vector<double> min_product_0;    // Menor produto de P(0) ao longo dos caminhos, excluindo o próprio nó
+    vector<double> max_product_0;
+    vector<double> min_product_1;    // Menor produto de P(1) ao longo dos caminhos, excluindo o próprio nó
+    vector<double> max_product_1;
+};
+
+
+
+
+
+// Função para calcular as estatísticas de caminhos de todos os nós sem enumerar os caminhos
+void computePathStatistics(const Netlist& netlist, PathStats& stats) {
+    ScopedTimer timer("path_stats");
+    const int n = netlist.size();
+    stats.path_count.assign(n, 0.0);
+    stats.shortest.assign(n, 0);
+    stats.longest.assign(n, 0);
+    stats.min_product_0.assign(n, 1.0);
+    stats.max_product_0.assign(n, 1.0);
+    stats.min_product_1.assign(n, 1.0);
+    stats.max_product_1.assign(n, 1.0);
+
+    for (int node : netlist.topo_order) {
+        if (netlist.ops[node] == OP_INPT) {
+            stats.path_count[node] = 1.0;
+            stats.shortest[node] = stats.longest[node] = 1;
+            continue;
+        }
+
+        const int* fanin = netlist.faninBegin(node);
+        const uint32_t count = pathFaninCount(netlist, node);
+        double paths = 0.0;
+        uint32_t shortest = UINT32_MAX, longest = 0;
+        double min_0 = INFINITY, max_0 = 0.0, min_1 = INFINITY, max_1 = 0.0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const int source = fanin[i];
+            if (stats.path_count[source] == 0.0) continue; // Ramo sem caminhos até as entradas
+
+            const int slot = netlist.pinSlot(netlist.fanin_offset[node] + i);
+            const double factor_0 = slot < 0 ? netlist.prob_0[source] : netlist.pin_prob_0[slot];
+            const double factor_1 = slot < 0 ? netlist.prob_1[source] : netlist.pin_prob_1[slot];
+
+            paths += stats.path_count[source];
+            shortest = min(shortest, stats.shortest[source] + 1);
+            longest = max(longest, stats.longest[source] + 1);
+            min_0 = min(min_0, factor_0 * stats.min_product_0[source]);
+            max_0 = max(max_0, factor_0 * stats.max_product_0[source]);
+            min_1 = min(min_1, factor_1 * stats.min_product_1[source]);
+            max_1 = max(max_1, factor_1 * stats.max_product_1[source]);
+        }
+
+        if (paths > 0.0) {
+            stats.path_count[node] = paths;
+            stats.shortest[node] = shortest;
+            stats.longest[node] = longest;
+            stats.min_product_0[node] = min_0;
+            stats.max_product_0[node] = max_0;
+            stats.min_product_1[node] = min_1;
+            stats.max_product_1[node] = max_1;
+        }
+    }
+}
+
+
+
+
+
+// Função para exibir os caminhos das saídas
+void displayOutputPaths(const PathDag& output_paths, const Netlist& netlist, string num, string source_directory) {
+    ScopedTimer timer("write_paths");
+    
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Outputs/";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
+
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + "Output" + num + ".txt";
+
+    // Abre o arquivo para escrita
+    ofstream output_file(file_path);
+
+    if (!output_file.is_open()) {
+        cerr << "Error opening file for writing!" << endl;
+        return;
+    }
+
+    // Os caminhos de cada saída são gerados sob demanda e escritos à medida que são produzidos
+    uint64_t enumerated = 0;
+    for (const auto& [output, cone] : output_paths.output_cones) {
+        output_file << "Output " << netlist.ids[output] << ":\n";
+        uint64_t possibility_count = 1;
+        PathIterator paths(netlist, output_paths, output);
+        while (paths.next()) {
+            const vector<int>& path = paths.path();
+            output_file << "  Logical Path " << possibility_count++ << ": ";
+            for (size_t i = 0; i < path.size(); ++i) {
+                const int node = path[i];
+                output_file << netlist.ids[node];
+
+                // Elementos com pinos extras (ex: sum_sub) são exibidos com o pino lido pelo elemento anterior do caminho
+                // (ex: ".2" é o carry-out, cujas probabilidades são exibidas no lugar das da saída principal)
+                int slot = -1;
+                if (i > 0 && extraOutputPins(netlist, node) > 0) {
+                    const int prev = path[i - 1];
+                    const int* fanin = netlist.faninBegin(prev);
+                    const uint32_t count = pathFaninCount(netlist, prev);
+                    for (uint32_t k = 0; k < count; ++k) {
+                        if (fanin[k] == node) {
+                            const uint32_t connection = netlist.fanin_offset[prev] + k;
+                            slot = netlist.pinSlot(connection);
+                            output_file << "." << (int)netlist.fanin_pin[connection];
+                            break;
+                        }
+                    }
+                }
+
+                if (slot >= 0) {
+                    output_file << " (0: " << netlist.pin_prob_0[slot] << "; 1: " << netlist.pin_prob_1[slot] << ")";
+                } else {
+                    output_file << " (0: " << netlist.prob_0[node] << "; 1: " << netlist.prob_1[node] << ")";
+                }
+                
+                if (i < path.size() - 1) {
+                    output_file << " <- ";
+                }
+            }
+            output_file << "\n";
+        }
+        enumerated += possibility_count - 1;
+        output_file << "\n"; // Linha em branco entre saídas
+    }
+    if (instrumentation.enabled) instrumentation.countPaths(enumerated);
+
+    timer.addBytes(output_file.tellp());
+    output_file.close(); // Fecha o arquivo
+}
+
+
+
+
+
+// Função para salvar as estatísticas de caminhos de cada saída e de cada elemento
+void savePathStatistics(const PathStats& stats, const PathDag& output_paths, const Netlist& netlist, string num, string source_directory) {
+    ScopedTimer timer("write_path_stats");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Path_Stats/";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
+
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + "Path_Stats" + num + ".txt";
+
+    // Abre o arquivo para escrita
+    ofstream output_file(file_path);
+
+    if (!output_file.is_open()) {
+        cerr << "Error opening file for writing!" << endl;
+        return;
+    }
+
+    // Contagem exata quando não saturou; caso contrário, a aproximação em ponto flutuante
+    auto write_count = [&](int node) {
+        if (output_paths.path_count[node] != UINT64_MAX) {
+            output_file << output_paths.path_count[node];
+        } else {
+            output_file << "~" << stats.path_count[node];
+        }
+    };
+
+    for (const auto& [output, cone] : output_paths.output_cones) {
+        output_file << "Output " << netlist.ids[output];
+        if (!netlist.name(output).empty()) output_file << " (" << netlist.name(output) << ")";
+        output_file << ":\n  Logical Paths: ";
+        write_count(output);
+        output_file << "\n  Cone Elements: " << cone.size() << "\n";
+        if (stats.path_count[output] > 0.0) {
+            output_file << "  Shortest Path: " << stats.shortest[output] << " elements\n";
+            output_file << "  Longest Path: " << stats.longest[output] << " elements\n";
+            output_file << "  Path Probability Product (0): min " << netlist.prob_0[output] * stats.min_product_0[output]
+                        << "; max " << netlist.prob_0[output] * stats.max_product_0[output] << "\n";
+            output_file << "  Path Probability Product (1): min " << netlist.prob_1[output] * stats.min_product_1[output]
+                        << "; max " << netlist.prob_1[output] * stats.max_product_1[output] << "\n";
+        }
+        output_file << "\n";
+    }
+
+    output_file << "Element\tPaths\tShortest\tLongest\n";
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        output_file << "   " << netlist.ids[node] << "\t";
+        write_count(node);
+        output_file << "\t" << stats.shortest[node] << "\t" << stats.longest[node] << "\n";
+    }
+
+    timer.addBytes(output_file.tellp());
+    output_file.close();
+}
+
+
+
+
+
+// Hashes estruturais do cone de entrada de cada nó, limitados a 0..depth níveis: hashes[d][nó]
+// Nível 0: opcode (e o nome, nas entradas, que não mudam de ID para ID entre netlists); nível d: opcode combinado com os
+// hashes de nível d - 1 das entradas e os pinos lidos. Nas portas comutativas a combinação não depende da ordem das entradas
+vector<vector<uint64_t>> computeConeHashes(const Netlist& netlist, int depth) {
+    const int n = netlist.size();
+    vector<vector<uint64_t>> hashes(depth + 1, vector<uint64_t>(n));
+    for (int node = 0; node < n; ++node) {
+        uint64_t h = nodeTypeHash(netlist, node);
+        if (netlist.ops[node] == OP_INPT) h ^= mix64(hash<string_view>()(netlist.name(node)));
+        hashes[0][node] = h;
+    }
+
+    for (int d = 1; d <= depth; ++d) {
+        for (int node = 0; node < n; ++node) {
+            const uint8_t op = netlist.ops[node];
+            if (op == OP_INPT) {
+                hashes[d][node] = hashes[0][node];
+                continue;
+            }
+            const bool commutative = op == OP_AND || op == OP_OR || op == OP_XOR || op == OP_NAND || op == OP_NOR || op == OP_XNOR;
+            uint64_t h = hashes[0][node];
+            for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+                const uint64_t child = mix64(hashes[d - 1][netlist.fanin[k]] + netlist.fanin_pin[k]);
+                h = commutative ? h + child : mix64(h ^ child);
+            }
+            hashes[d][node] = mix64(h);
+        }
+    }
+    return hashes;
+}
+
+// Função para parear as saídas das duas netlists por assinatura, em vez da posição na lista ordenada por ID
+// Os pares são formados em etapas, cada uma um único passe com tabela hash sobre as saídas ainda sem par:
+//   1. nome ("//nome") e hash estrutural do cone até 'depth' níveis (saídas idênticas; empates pareados em ordem de ID);
+//   2. somente o nome, quando ele é único em cada netlist (o cone foi alterado, ex: trojan);
+//   3. somente o hash estrutural, de depth - 1 até 1 nível, quando único em cada netlist (saídas sem nome ou renomeadas);
+//   4. o conjunto de entradas do cone (por nome, ou por ID quando sem nome), quando único em cada netlist;
+//   5. se sobrar a mesma quantidade de saídas nas duas netlists, elas são pareadas pela posição em ordem de ID
+//      (o pareamento original); se as quantidades diferirem, saídas foram adicionadas ou removidas e ficam sem par.
+// Retorna os pares (saída da netlist 1, saída da netlist 2) em ordem de ID da netlist 1
+vector<pair<int, int>> matchOutputs(const Netlist& netlist1, const Netlist& netlist2,
+                                    const vector<int>& outputs1, const vector<int>& outputs2, int depth) {
+    const auto hashes1 = computeConeHashes(netlist1, depth);
+    const auto hashes2 = computeConeHashes(netlist2, depth);
+    vector<int> match1(outputs1.size(), -1), match2(outputs2.size(), -1);
+
+    // Uma etapa de pareamento: key(netlist, saída, &chave) retorna false para saídas que não participam da etapa
+    auto matchBy = [&](auto&& key, bool require_unique) {
+        unordered_map<uint64_t, vector<int>> index; // Chave -> posições em outputs2 ainda sem par
+        index.reserve(outputs2.size());
+        uint64_t k;
+        for (size_t j = 0; j < outputs2.size(); ++j) {
+            if (match2[j] < 0 && key(netlist2, hashes2, outputs2[j], k)) index[k].push_back(j);
+        }
+        unordered_map<uint64_t, int> count1;
+        if (require_unique) {
+            for (size_t i = 0; i < outputs1.size(); ++i) {
+                if (match1[i] < 0 && key(netlist1, hashes1, outputs1[i], k)) count1[k]++;
+            }
+        }
+        unordered_map<uint64_t, size_t> next; // Próximo candidato de cada chave (empates em ordem de ID)
+        for (size_t i = 0; i < outputs1.size(); ++i) {
+            if (match1[i] >= 0 || !key(netlist1, hashes1, outputs1[i], k)) continue;
+            const auto it = index.find(k);
+            if (it == index.end()) continue;
+            if (require_unique && (it->second.size() != 1 || count1[k] != 1)) continue;
+            size_t& position = next[k];
+            if (position < it->second.size()) {
+                const int j = it->second[position++];
+                match1[i] = j;
+                match2[j] = i;
+            }
+        }
+    };
+
+    auto nameHash = [](const Netlist& netlist, int node) { return mix64(hash<string_view>()(netlist.name(node))); };
+    matchBy([&](const Netlist& netlist, const auto& hashes, int node, uint64_t& key) {
+        key = nameHash(netlist, node) ^ hashes[depth][node];
+        return true;
+    }, false);
+    matchBy([&](const Netlist& netlist, const auto&, int node, uint64_t& key) {
+        key = nameHash(netlist, node);
+        return !netlist.name(node).empty();
+    }, true);
+    for (int d = depth - 1; d >= 1; --d) {
+        matchBy([&](const Netlist&, const auto& hashes, int node, uint64_t& key) {
+            key = hashes[d][node];
+            return true;
+        }, true);
+    }
+
+    // Conjunto de entradas do cone de cada saída, combinado de forma independente da ordem
+    auto supportHashes = [](const Netlist& netlist, const vector<int>& outputs, const vector<int>& match) {
+        vector<uint64_t> support(outputs.size(), 0);
+        vector<int> visited(netlist.size(), -1), pending;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            if (match[i] >= 0) continue;
+            pending.assign(1, outputs[i]);
+            visited[outputs[i]] = i;
+            while (!pending.empty()) {
+                const int node = pending.back();
+                pending.pop_back();
+                if (netlist.ops[node] == OP_INPT) {
+                    const string_view name = netlist.name(node);
+                    support[i] += mix64(name.empty() ? netlist.ids[node] : hash<string_view>()(name));
+                }
+                for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+                    const int source = netlist.fanin[k];
+                    if (visited[source] != (int)i) {
+                        visited[source] = i;
+                        pending.push_back(source);
+                    }
+                }
+            }
+        }
+        return support;
+    };
+    const vector<uint64_t> support1 = supportHashes(netlist1, outputs1, match1);
+    const vector<uint64_t> support2 = supportHashes(netlist2, outputs2, match2);
+    unordered_map<int, size_t> position1, position2;
+    for (size_t i = 0; i < outputs1.size(); ++i) position1[outputs1[i]] = i;
+    for (size_t j = 0; j < outputs2.size(); ++j) position2[outputs2[j]] = j;
+    matchBy([&](const Netlist& netlist, const auto&, int node, uint64_t& key) {
+        key = &netlist == &netlist1 ? support1[position1[node]] : support2[position2[node]];
+        return true;
+    }, true);
+
+    vector<int> rest1, rest2;
+    for (size_t i = 0; i < outputs1.size(); ++i) {
+        if (match1[i] < 0) rest1.push_back(i);
+    }
+    for (size_t j = 0; j < outputs2.size(); ++j) {
+        if (match2[j] < 0) rest2.push_back(j);
+    }
+    if (rest1.size() == rest2.size()) {
+        for (size_t r = 0; r < rest1.size(); ++r) match1[rest1[r]] = rest2[r];
+    }
+
+    vector<pair<int, int>> pairs;
+    for (size_t i = 0; i < outputs1.size(); ++i) {
+        if (match1[i] >= 0) pairs.push_back({outputs1[i], outputs2[match1[i]]});
+    }
+    return pairs;
+}
+
+// Critério de ordenação do relatório de divergências
+enum DivergenceScore : uint8_t {
+    SCORE_DELTA_P1,   // |ΔP(1)|
+    SCORE_KL,         // Divergência KL da distribuição (P(0), P(1), transição) da Netlist 1 para a da Netlist 2
+    SCORE_TRANSITION  // |Δ(P(0) * P(1))|, a probabilidade de transição de saveTransitionProbabilities
+};
+const char* const SCORE_NAMES[] = {"dp1", "kl", "transition"};
+
+struct DivergenceOptions {
+    double abs_threshold = 1e-9;   // Diferença mínima em P(0) ou P(1) para uma saída divergir
+    double rel_threshold = 0.0;    // A mesma diferença relativa a max(P da Netlist 1, P da Netlist 2)
+    size_t top_k = 0;              // Divergências mantidas no relatório (0 = todas)
+    DivergenceScore rank_by = SCORE_DELTA_P1;
+    int match_depth = 4;           // Níveis do cone usados no pareamento estrutural das saídas
+};
+
+// Saída divergente (ou sem par) com as suas pontuações
+struct OutputDivergence {
+    int output1;             // Saída da Netlist 1 (-1 se a saída da Netlist 2 não tem par)
+    int output2;             // Saída da Netlist 2 (-1 se a saída da Netlist 1 não tem par)
+    double delta_p1 = 0.0;
+    double kl = 0.0;
+    double delta_transition = 0.0;
+    double score = INFINITY; // Pontuação usada na ordenação; saídas sem par ficam à frente de todas
+};
+
+// Resultado da comparação: só as top_k divergências de maior pontuação são guardadas
+struct DivergenceReport {
+    vector<OutputDivergence> top; // Em ordem decrescente de pontuação (empates em ordem de ID)
+    size_t divergent = 0;         // Total de saídas divergentes ou sem par, inclusive as descartadas pelo top_k
+    DivergenceScore rank_by = SCORE_DELTA_P1;
 };
 
+// Divergência KL da distribuição (P(0), P(1), transição = 1 - P(0) - P(1)) de uma saída para a de outra
+inline double outputKlDivergence(double p0, double p1, double q0, double q1) {
+    const double floor = 1e-12; // Evita log(0) em probabilidades nulas
+    auto term = [&](double p, double q) { return p > 0.0 ? p * log(p / max(q, floor)) : 0.0; };
+    return term(p0, q0) + term(p1, q1) + term(1.0 - p0 - p1, 1.0 - q0 - q1);
+}
 
+// Função para comparar as probabilidades e identificar divergências
+// As saídas são pareadas por matchOutputs; saídas sem par em qualquer uma das netlists são relatadas como tal.
+// Cada par acima dos limiares é pontuado e disputa uma das top_k posições em um heap limitado, então a memória
+// do relatório não depende da quantidade de saídas; as mensagens são formatadas só para as sobreviventes, em
+// saveDivergences. A comparação só lê as probabilidades das saídas: os caminhos são rastreados depois, apenas
+// para as saídas do relatório
+DivergenceReport compareProbabilities(const Netlist& netlist1, const Netlist& netlist2,
+                                      const DivergenceOptions& options = DivergenceOptions()) {
+    ScopedTimer timer("compare");
+
+    DivergenceReport report;
+    report.rank_by = options.rank_by;
+
+    // Ordem do relatório: pontuação decrescente, depois ID (saídas da Netlist 1 antes das sem par da Netlist 2)
+    const long long n1 = netlist1.size();
+    auto key = [&](const OutputDivergence& d) { return d.output1 >= 0 ? d.output1 : n1 + d.output2; };
+    auto ranked_before = [&](const OutputDivergence& a, const OutputDivergence& b) {
+        return a.score != b.score ? a.score > b.score : key(a) < key(b);
+    };
+    // O heap mantém no topo a pior das divergências guardadas, a primeira a sair quando chega uma melhor
+    auto offer = [&](const OutputDivergence& d) {
+        report.divergent++;
+        if (options.top_k > 0 && report.top.size() == options.top_k) {
+            if (!ranked_before(d, report.top.front())) return;
+            pop_heap(report.top.begin(), report.top.end(), ranked_before);
+            report.top.pop_back();
+        }
+        report.top.push_back(d);
+        push_heap(report.top.begin(), report.top.end(), ranked_before);
+    };
+    auto differs = [&](double a, double b) {
+        const double delta = abs(a - b);
+        return delta >= options.abs_threshold && delta >= options.rel_threshold * max(abs(a), abs(b));
+    };
+
+    const vector<int> outputs1 = listOutputs(netlist1), outputs2 = listOutputs(netlist2);
+    const vector<pair<int, int>> pairs = matchOutputs(netlist1, netlist2, outputs1, outputs2, options.match_depth);
+    vector<char> paired1(netlist1.size(), 0), paired2(netlist2.size(), 0);
+
+    for (const auto& [out1, out2] : pairs) {
+        paired1[out1] = paired2[out2] = 1;
+        const double prob1_0 = netlist1.prob_0[out1], prob1_1 = netlist1.prob_1[out1];
+        const double prob2_0 = netlist2.prob_0[out2], prob2_1 = netlist2.prob_1[out2];
+
+        // Pares abaixo dos limiares (ex: ruído de ponto flutuante) não são relatados
+        if (!differs(prob1_0, prob2_0) && !differs(prob1_1, prob2_1)) continue;
+
+        OutputDivergence d{out1, out2};
+        d.delta_p1 = abs(prob1_1 - prob2_1);
+        d.kl = outputKlDivergence(prob1_0, prob1_1, prob2_0, prob2_1);
+        d.delta_transition = abs(prob1_0 * prob1_1 - prob2_0 * prob2_1);
+        d.score = options.rank_by == SCORE_KL ? d.kl : options.rank_by == SCORE_TRANSITION ? d.delta_transition : d.delta_p1;
+        offer(d);
+    }
 
+    // Saídas sem par em qualquer uma das netlists
+    for (int out1 : outputs1) {
+        if (!paired1[out1]) offer(OutputDivergence{out1, -1});
+    }
+    for (int out2 : outputs2) {
+        if (!paired2[out2]) offer(OutputDivergence{-1, out2});
+    }
 
+    sort(report.top.begin(), report.top.end(), ranked_before);
+    return report;
+}
 
-// Função para ler o arquivo e construir o grafo da netlist
-void parseNetlist(const string& filename, map<int, Element>& netlist) {
-    ifstream file(filename);
+// Saídas de uma das netlists (1 ou 2) presentes no relatório de divergências, em ordem de ID
+vector<int> reportedOutputs(const DivergenceReport& report, int netlist) {
+    vector<int> outputs;
+    for (const OutputDivergence& d : report.top) {
+        const int output = netlist == 1 ? d.output1 : d.output2;
+        if (output >= 0) outputs.push_back(output);
+    }
+    sort(outputs.begin(), outputs.end());
+    return outputs;
+}
+
+// Função para acrescentar às saídas rastreadas as pedidas pelo usuário, por ID ("17") ou nome ("//soma")
+// found[k] passa a 1 quando o pedido k corresponde a alguma saída da netlist
+void addRequestedOutputs(const Netlist& netlist, const vector<string>& requested, vector<int>& outputs, vector<char>& found) {
+    const vector<int> candidates = listOutputs(netlist);
+    for (size_t k = 0; k < requested.size(); ++k) {
+        const string_view ref = requested[k];
+        for (int output : candidates) {
+            const bool match = ref.rfind("//", 0) == 0 ? netlist.name(output) == ref.substr(2) : to_string(netlist.ids[output]) == ref;
+            if (!match) continue;
+            outputs.push_back(output);
+            found[k] = 1;
+        }
+    }
+    sort(outputs.begin(), outputs.end());
+    outputs.erase(unique(outputs.begin(), outputs.end()), outputs.end());
+}
+
+
+
+
+// Função para criar o arquivo com as divergências entre as netlists (somente as do relatório, já ordenadas)
+void saveDivergences(const DivergenceReport& report, const Netlist& netlist1, const Netlist& netlist2,
+                     string source_directory, const string& output_filename = "Output_Divergences") {
+    ScopedTimer timer("write_divergences");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Divergences";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
+
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + "/" + output_filename + ".txt";
+
+    // Abre o arquivo para escrita
+    ofstream file(file_path);
+    
+    if (report.divergent == 0) {
+        file << "No divergences were found!";
+    } else {
+        file << "Showing " << report.top.size() << " of " << report.divergent << " divergent output(s), ranked by "
+             << SCORE_NAMES[report.rank_by] << "\n\n";
+    }
+
+    const string separator = "----------------------------------------------------------------------------------------------\n";
+    for (size_t k = 0; k < report.top.size(); ++k) {
+        const OutputDivergence& d = report.top[k];
+        if (d.output2 < 0) {
+            file << "Unmatched Output: Output " << netlist1.ids[d.output1] << " from Netlist 1 (Prob 0: " << netlist1.prob_0[d.output1]
+                 << ", Prob 1: " << netlist1.prob_1[d.output1] << ") has no equivalent in Netlist 2.\n";
+        } else if (d.output1 < 0) {
+            file << "Unmatched Output: Output " << netlist2.ids[d.output2] << " from Netlist 2 (Prob 0: " << netlist2.prob_0[d.output2]
+                 << ", Prob 1: " << netlist2.prob_1[d.output2] << ") has no equivalent in Netlist 1.\n";
+        } else {
+            file << "Divergent Output: Output " << netlist1.ids[d.output1] << " from Netlist 1 (Prob 0: " << netlist1.prob_0[d.output1]
+                 << ", Prob 1: " << netlist1.prob_1[d.output1] << ") diverges from Output " << netlist2.ids[d.output2]
+                 << " from Netlist 2 (Prob 0: " << netlist2.prob_0[d.output2] << ", Prob 1: " << netlist2.prob_1[d.output2] << ").\n";
+            file << "  Scores: |dP1| " << d.delta_p1 << ", KL " << d.kl << ", |dTransition| " << d.delta_transition << "\n";
+        }
+        file << "\n" << separator;
+        if (k + 1 < report.top.size()) file << "\n";
+    }
+
+    timer.addBytes(file.tellp());
+    file.close();
+}
+
+
+
+
+
+// Ponto de divergência interno: um nó da fronteira entre as regiões estruturalmente idênticas e as alteradas
+enum LocalizationKind : uint8_t {
+    LOCALIZED_CHANGED, // Nó da Netlist 2 com correspondente na Netlist 1 (mesmo nome ou mesmas entradas), mas estrutura diferente
+    LOCALIZED_ADDED,   // Nó da Netlist 2 sem correspondente na Netlist 1
+    LOCALIZED_REMOVED  // Nó da Netlist 1 sem correspondente na Netlist 2
+};
+
+struct LocalizedDivergence {
+    LocalizationKind kind;
+    int node;          // Índice na Netlist 2 (ou na Netlist 1, se removido)
+    int counterpart;   // Índice do correspondente na outra netlist (-1 se não houver)
+    double delta_0;    // P(0) na Netlist 2 - P(0) na Netlist 1 (0 sem correspondente)
+    double delta_1;
+    double impact;     // Maior |ΔP| entre os nós com correspondente no cone de fanout (incluindo o próprio nó)
+    size_t outputs;    // Saídas alcançadas pelo cone de fanout
+};
+
+// Hash estrutural canônico de cada nó (strashing, como em AIGs): opcode combinado com os hashes das entradas, ordenados
+// nas portas comutativas, e os pinos lidos. Entradas são identificadas pelo nome ou, sem nome, pelo ID
+vector<uint64_t> computeStructuralHashes(const Netlist& netlist) {
+    vector<uint64_t> hashes(netlist.size());
+    vector<uint64_t> children;
+    for (int node : netlist.topo_order) {
+        const uint8_t op = netlist.ops[node];
+        uint64_t h = nodeTypeHash(netlist, node);
+        if (op == OP_INPT) {
+            const string_view name = netlist.name(node);
+            hashes[node] = h ^ mix64(name.empty() ? netlist.ids[node] : hash<string_view>()(name));
+            continue;
+        }
+        children.clear();
+        for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+            children.push_back(mix64(hashes[netlist.fanin[k]] + netlist.fanin_pin[k]));
+        }
+        if (op == OP_AND || op == OP_OR || op == OP_XOR || op == OP_NAND || op == OP_NOR || op == OP_XNOR) {
+            sort(children.begin(), children.end());
+        }
+        for (uint64_t child : children) h = mix64(h ^ child);
+        hashes[node] = h;
+    }
+    return hashes;
+}
+
+// Função para localizar onde as netlists passam a diferir
+// Os nós com hash estrutural presente na outra netlist formam as regiões idênticas (alinhadas em O(n) por tabela hash).
+// A fronteira são os nós sem par cujas entradas têm todas par: os primeiros elementos alterados, adicionados ou removidos.
+// Cada nó da fronteira recebe um correspondente (par de saídas de matchOutputs, nome único ou as mesmas entradas) para o cálculo de ΔP e é
+// classificado pelo impacto que propaga até as saídas; retorna a lista ordenada do maior para o menor impacto.
+// match_depth deve ser o mesmo da comparação, para que as saídas sejam pareadas como no relatório de divergências
+vector<LocalizedDivergence> localizeDivergences(const Netlist& netlist1, const Netlist& netlist2, int match_depth = 4) {
+    ScopedTimer timer("localize");
+    const int n1 = netlist1.size(), n2 = netlist2.size();
+    const vector<uint64_t> hashes1 = computeStructuralHashes(netlist1);
+    const vector<uint64_t> hashes2 = computeStructuralHashes(netlist2);
+
+    // As tabelas indexadas por elemento alocam um nó a cada inserção; todos vêm de uma arena monotônica, liberada
+    // de uma só vez no fim da função, em vez de centenas de milhares de alocações pequenas no heap
+    pmr::monotonic_buffer_resource arena;
+    pmr::unordered_map<uint64_t, pmr::vector<int>> by_hash1(&arena);
+    by_hash1.reserve(n1);
+    for (int node = 0; node < n1; ++node) by_hash1[hashes1[node]].push_back(node);
+    pmr::unordered_set<uint64_t> hash_set2(&arena);
+    hash_set2.reserve(n2);
+    hash_set2.insert(hashes2.begin(), hashes2.end());
+
+    // Correspondências: primeiro as estruturalmente idênticas. Elementos duplicados (mesmo hash) são pareados
+    // preferindo o mesmo nome e depois o primeiro ainda livre, para que cada um tenha no máximo um correspondente
+    vector<int> counterpart1(n1, -1), counterpart2(n2, -1);
+    vector<char> matched1(n1, 0), matched2(n2, 0);
+    for (int node = 0; node < n1; ++node) matched1[node] = hash_set2.count(hashes1[node]) > 0;
+    for (int node = 0; node < n2; ++node) {
+        const auto it = by_hash1.find(hashes2[node]);
+        if (it == by_hash1.end()) continue;
+        matched2[node] = 1;
+        int chosen = -1;
+        for (int candidate : it->second) {
+            if (counterpart1[candidate] >= 0) continue;
+            if (chosen < 0) chosen = candidate;
+            if (netlist1.name(candidate) == netlist2.name(node)) {
+                chosen = candidate;
+                break;
+            }
+        }
+        counterpart2[node] = chosen >= 0 ? chosen : it->second.front();
+        if (chosen >= 0) counterpart1[chosen] = node;
+    }
+
+    // Saídas alteradas recebem o par escolhido por matchOutputs, o mesmo usado no relatório de divergências
+    vector<int> outputs1, outputs2;
+    for (int node = 0; node < n1; ++node) {
+        if (netlist1.ops[node] == OP_OUT) outputs1.push_back(node);
+    }
+    for (int node = 0; node < n2; ++node) {
+        if (netlist2.ops[node] == OP_OUT) outputs2.push_back(node);
+    }
+    for (const auto& [out1, out2] : matchOutputs(netlist1, netlist2, outputs1, outputs2, match_depth)) {
+        if (matched1[out1] || matched2[out2] || counterpart1[out1] >= 0) continue;
+        counterpart1[out1] = out2;
+        counterpart2[out2] = out1;
+    }
+
+    // Depois os nós alterados: nome único entre os nós ainda sem correspondente, senão o mesmo conjunto de entradas (ex: troca de tipo)
+    auto fanin_key = [](const Netlist& netlist, const vector<uint64_t>& hashes, int node) {
+        uint64_t key = 0;
+        for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+            key += mix64(hashes[netlist.fanin[k]] + netlist.fanin_pin[k]);
+        }
+        return key;
+    };
+    pmr::unordered_map<string_view, int> by_name1(&arena);
+    pmr::unordered_map<uint64_t, int> by_fanin1(&arena);
+    for (int node = 0; node < n1; ++node) {
+        if (counterpart1[node] >= 0) continue;
+        if (!netlist1.name(node).empty()) {
+            const auto [it, inserted] = by_name1.emplace(netlist1.name(node), node);
+            if (!inserted) it->second = -1; // Nome repetido: não identifica o nó
+        }
+        if (netlist1.faninCount(node) > 0) {
+            const auto [it, inserted] = by_fanin1.emplace(fanin_key(netlist1, hashes1, node), node);
+            if (!inserted) it->second = -1;
+        }
+    }
+    for (int node = 0; node < n2; ++node) {
+        if (matched2[node] || counterpart2[node] >= 0) continue;
+        int other = -1;
+        const auto name_it = netlist2.name(node).empty() ? by_name1.end() : by_name1.find(netlist2.name(node));
+        if (name_it != by_name1.end()) other = name_it->second;
+        if (other < 0 && netlist2.faninCount(node) > 0) {
+            const auto fanin_it = by_fanin1.find(fanin_key(netlist2, hashes2, node));
+            if (fanin_it != by_fanin1.end()) other = fanin_it->second;
+        }
+        if (other >= 0 && counterpart1[other] < 0) {
+            counterpart2[node] = other;
+            counterpart1[other] = node;
+        }
+    }
+
+    auto on_frontier = [](const Netlist& netlist, const vector<char>& matched, int node) {
+        if (matched[node]) return false;
+        for (uint32_t k = netlist.fanin_offset[node]; k < netlist.fanin_offset[node + 1]; ++k) {
+            if (!matched[netlist.fanin[k]]) return false;
+        }
+        return true;
+    };
+
+    // Impacto: maior |ΔP| no cone de fanout de cada nó e quantidade de saídas alcançadas, calculados para todos os nós
+    // em uma passagem em ordem topológica reversa (o máximo de um cone é o do próprio nó e o dos cones das suas saídas;
+    // cones sobrepostos não atrapalham). As saídas alcançadas são contadas sem repetição por máscaras de bits, 64 saídas
+    // por passagem, então o custo é O((n + conexões) · ⌈saídas / 64⌉) em vez de uma busca por nó da fronteira
+    struct ConeImpact {
+        vector<double> impact;
+        vector<uint32_t> outputs;
+    };
+    auto cone_impact = [](const Netlist& netlist, const vector<int>& counterpart, const Netlist& other) {
+        const int n = netlist.size();
+        ConeImpact cone{vector<double>(n, 0.0), vector<uint32_t>(n, 0)};
+        for (auto it = netlist.topo_order.rbegin(); it != netlist.topo_order.rend(); ++it) {
+            const int node = *it;
+            const int c = counterpart[node];
+            double impact = c >= 0 ? max(abs(netlist.prob_0[node] - other.prob_0[c]), abs(netlist.prob_1[node] - other.prob_1[c])) : 0.0;
+            for (uint32_t e = netlist.fanout_offset[node]; e < netlist.fanout_offset[node + 1]; ++e) {
+                impact = max(impact, cone.impact[netlist.fanout[e]]);
+            }
+            cone.impact[node] = impact;
+        }
+
+        vector<int> outputs;
+        for (int node = 0; node < n; ++node) {
+            if (netlist.ops[node] == OP_OUT) outputs.push_back(node);
+        }
+        vector<uint64_t> reached(n);
+        for (size_t base = 0; base < outputs.size(); base += 64) {
+            fill(reached.begin(), reached.end(), 0);
+            for (size_t k = base; k < min(outputs.size(), base + 64); ++k) reached[outputs[k]] = 1ull << (k - base);
+            for (auto it = netlist.topo_order.rbegin(); it != netlist.topo_order.rend(); ++it) {
+                const int node = *it;
+                for (uint32_t e = netlist.fanout_offset[node]; e < netlist.fanout_offset[node + 1]; ++e) {
+                    reached[node] |= reached[netlist.fanout[e]];
+                }
+                cone.outputs[node] += __builtin_popcountll(reached[node]);
+            }
+        }
+        return cone;
+    };
+    auto measure = [](LocalizedDivergence& entry, const ConeImpact& cone) {
+        entry.impact = cone.impact[entry.node];
+        entry.outputs = cone.outputs[entry.node];
+    };
+
+    vector<LocalizedDivergence> result;
+    const ConeImpact cone2 = cone_impact(netlist2, counterpart2, netlist1);
+    for (int node = 0; node < n2; ++node) {
+        if (!on_frontier(netlist2, matched2, node)) continue;
+        const int c = counterpart2[node];
+        LocalizedDivergence entry{c >= 0 ? LOCALIZED_CHANGED : LOCALIZED_ADDED, node, c, 0.0, 0.0, 0.0, 0};
+        if (c >= 0) {
+            entry.delta_0 = netlist2.prob_0[node] - netlist1.prob_0[c];
+            entry.delta_1 = netlist2.prob_1[node] - netlist1.prob_1[c];
+        }
+        measure(entry, cone2);
+        result.push_back(entry);
+    }
+    ConeImpact cone1;
+    for (int node = 0; node < n1; ++node) {
+        if (counterpart1[node] >= 0 || !on_frontier(netlist1, matched1, node)) continue;
+        if (cone1.impact.empty()) cone1 = cone_impact(netlist1, counterpart1, netlist2);
+        LocalizedDivergence entry{LOCALIZED_REMOVED, node, -1, 0.0, 0.0, 0.0, 0};
+        measure(entry, cone1);
+        result.push_back(entry);
+    }
+
+    sort(result.begin(), result.end(), [](const LocalizedDivergence& a, const LocalizedDivergence& b) {
+        const double own_a = max(abs(a.delta_0), abs(a.delta_1)), own_b = max(abs(b.delta_0), abs(b.delta_1));
+        if (a.impact != b.impact) return a.impact > b.impact;
+        if (own_a != own_b) return own_a > own_b;
+        if (a.outputs != b.outputs) return a.outputs > b.outputs;
+        return make_pair(a.kind, a.node) < make_pair(b.kind, b.node);
+    });
+    return result;
+}
+
+// Função para salvar a lista ordenada dos pontos de divergência internos em Divergences/<output_filename>.txt
+void saveLocalization(const vector<LocalizedDivergence>& localized, const Netlist& netlist1, const Netlist& netlist2,
+                      string source_directory, const string& output_filename = "Localization") {
+    ScopedTimer timer("write_localization");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Divergences";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
 
+    ofstream file(directory + "/" + output_filename + ".txt");
     if (!file.is_open()) {
-        cerr << "Error: Could not open file " << filename << endl;
+        cerr << "Error opening file " << output_filename << " for writing!" << endl;
+        return;
+    }
+
+    if (localized.empty()) {
+        file << "The netlists are structurally identical.";
+        timer.addBytes(file.tellp());
+        return;
+    }
+
+    auto describe = [&](const Netlist& netlist, int node) {
+        stringstream ss;
+        ss << netlist.ids[node] << " (" << OP_NAMES[netlist.ops[node]];
+        if (!netlist.name(node).empty()) ss << " //" << netlist.name(node);
+        ss << "; 0: " << netlist.prob_0[node] << "; 1: " << netlist.prob_1[node] << ")";
+        return ss.str();
+    };
+
+    file << "Rank\tKind\tElement\tCounterpart\tDelta 0\tDelta 1\tImpact\tOutputs\n";
+    for (size_t k = 0; k < localized.size(); ++k) {
+        const LocalizedDivergence& entry = localized[k];
+        file << k + 1 << "\t";
+        if (entry.kind == LOCALIZED_REMOVED) {
+            file << "removed\t" << describe(netlist1, entry.node) << " from Netlist 1\t-\t-\t-\t";
+        } else {
+            file << (entry.kind == LOCALIZED_CHANGED ? "changed\t" : "added\t") << describe(netlist2, entry.node) << " from Netlist 2\t";
+            if (entry.counterpart >= 0) {
+                file << describe(netlist1, entry.counterpart) << " from Netlist 1\t" << entry.delta_0 << "\t" << entry.delta_1 << "\t";
+            } else {
+                file << "-\t-\t-\t";
+            }
+        }
+        file << entry.impact << "\t" << entry.outputs << "\n";
+    }
+    timer.addBytes(file.tellp());
+}
+
+
+
+
+
+// Função para salvar as probabilidades de transição em um arquivo
+void saveTransitionProbabilities(const Netlist& netlist, const string& output_filename, string source_directory) {
+    ScopedTimer timer("write_transitions");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Table_Transitions/";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
+
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + output_filename + ".txt";
+
+    // Abre o arquivo para escrita
+    ofstream output_file(file_path);
+
+    if (!output_file.is_open()) {
+        cerr << "Error opening file " << output_filename << " for writing!" << endl;
+        return;
+    }
+
+    output_file << "Element\tTransition Probability\n";
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        double transition_prob = netlist.prob_0[node] * netlist.prob_1[node];
+        output_file << "   " << netlist.ids[node] << "\t\t      " << transition_prob << "\n";
+    }
+
+    timer.addBytes(output_file.tellp());
+    output_file.close();
+}
+
+
+
+
+
+
+// Função para salvar as estimativas de Monte Carlo, com intervalos de confiança de 95% e as probabilidades analíticas
+// Elementos cujo valor analítico fica fora do intervalo são marcados com '*'
+void saveMonteCarloProbabilities(const MonteCarloResult& result, const Netlist& netlist, const string& output_filename, string source_directory) {
+    ScopedTimer timer("write_monte_carlo");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Monte_Carlo/";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
+
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + output_filename + ".txt";
+
+    // Abre o arquivo para escrita
+    ofstream output_file(file_path);
+
+    if (!output_file.is_open()) {
+        cerr << "Error opening file " << output_filename << " for writing!" << endl;
         return;
     }
 
+    output_file << "Samples: " << result.samples << "\n";
+    output_file << "Element\tProb 0 [95% CI]\t\tProb 1 [95% CI]\t\tAnalytic 0\tAnalytic 1\n";
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        const auto ci_0 = wilsonInterval(result.count_0[node], result.samples);
+        const auto ci_1 = wilsonInterval(result.count_1[node], result.samples);
+        const bool outside = netlist.prob_0[node] < ci_0.first || netlist.prob_0[node] > ci_0.second
+                          || netlist.prob_1[node] < ci_1.first || netlist.prob_1[node] > ci_1.second;
+        output_file << "   " << netlist.ids[node] << "\t"
+                    << (double)result.count_0[node] / result.samples << " [" << ci_0.first << ", " << ci_0.second << "]\t"
+                    << (double)result.count_1[node] / result.samples << " [" << ci_1.first << ", " << ci_1.second << "]\t"
+                    << netlist.prob_0[node] << "\t" << netlist.prob_1[node] << (outside ? "\t*" : "") << "\n";
+    }
+
+    timer.addBytes(output_file.tellp());
+    output_file.close();
+}
+
+
+
+
+
+// Função para gerar cenários aleatórios de probabilidades de entrada em um lote
+// O cenário 0 mantém as probabilidades da netlist; nos demais, cada entrada recebe P(0) e P(1) sorteados com P(0) + P(1) <= 1
+// Os sorteios dependem só de (semente, cenário, entrada), com a entrada identificada pelo nome (sem nome, pelo ID), como nos
+// hashes estruturais: entradas de mesmo nome recebem os mesmos valores nas duas netlists, mesmo em ordens ou conjuntos diferentes
+void fillRandomScenarios(const Netlist& netlist, ScenarioBatch& batch, uint64_t seed) {
+    auto uniform = [&](uint64_t input, size_t scenario, int draw) {
+        return (counterRandom(seed, input, scenario * 2 + draw) >> 11) * 0x1.0p-53;
+    };
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        if (netlist.ops[node] != OP_INPT) continue;
+        const string_view name = netlist.name(node);
+        const uint64_t input = mix64(name.empty() ? netlist.ids[node] : hash<string_view>()(name));
+        for (size_t k = 1; k < batch.scenarios; ++k) {
+            const double defined = uniform(input, k, 0); // Probabilidade de o sinal estar em 0 ou em 1
+            const double prob_1 = defined * uniform(input, k, 1);
+            batch.p1(node)[k] = prob_1;
+            batch.p0(node)[k] = defined - prob_1;
+        }
+    }
+}
+
+
+
+
+
+// Perfil de probabilidades de entrada: atribui P(0)/P(1) a entradas identificadas por ID, por nome ("//Sel0") ou "*" (todas)
+struct ProfileEntry {
+    string ref;
+    double prob_0;
+    double prob_1;
+};
+
+struct ProbabilityProfile {
+    string name;
+    vector<ProfileEntry> entries;
+};
+
+
+
+
+
+// Função para ler um arquivo de perfis de probabilidade de entrada
+// Formato (linhas iniciadas por '#' são comentários):
+//   profile <nome>
+//   <ID | //nome | *> <P(0)> <P(1)>
+//   end
+// Entradas não citadas em um perfil mantêm as probabilidades padrão da netlist
+vector<ProbabilityProfile> parseProfiles(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open profile file " + filename);
+    }
+
+    vector<ProbabilityProfile> profiles;
+    bool in_profile = false;
     string line;
+    int line_number = 0;
     while (getline(file, line)) {
-        if (line.empty()) {
-            continue; // Ignorar linhas em branco
+        line_number++;
+        stringstream ss(line);
+        string first;
+        if (!(ss >> first) || first[0] == '#') {
+            continue; // Ignorar linhas em branco e comentários
         }
 
-        stringstream ss(line);
-        Element elem;
-        int num_outputs, num_inputs;
-        ss >> elem.id >> elem.type >> num_outputs >> num_inputs;
-
-        // Inicializar probabilidades para "inpt"
-        if (elem.type == "inpt") {
-            elem.prob_0 = 0.25; // Probabilidade padrão para 0
-            elem.prob_1 = 0.25; // Probabilidade padrão para 1
-        } else {
-            elem.prob_0 = 1.0; // Valores iniciais genéricos para outros tipos
-            elem.prob_1 = 1.0;
-        }
-
-        // Ler conexões para outros tipos
-        if (elem.type == "sum_sub") {
-            // Ler três linhas específicas para sum_sub
-            // Primeira linha: entradas
-            getline(file, line);
-            stringstream inputs_stream(line);
-            float input;
-            while (inputs_stream >> input) {
-                elem.connections.push_back(input);
-            }
-
-            // Segunda linha: carry_in
-            getline(file, line);
-            stringstream carry_stream(line);
-            float carry_in;
-            carry_stream >> carry_in;
-            elem.connections.push_back(carry_in);
-
-            // Terceira linha: operando
-            getline(file, line);
-            stringstream op_stream(line);
-            int op;
-            op_stream >> op;
-            elem.selectors.push_back(op);
+        const string location = filename + ":" + to_string(line_number);
+        if (first == "profile") {
+            if (in_profile) throw runtime_error("Missing 'end' before new profile at " + location);
+            ProbabilityProfile profile;
+            if (!(ss >> profile.name)) throw runtime_error("Profile without name at " + location);
+            profiles.push_back(profile);
+            in_profile = true;
+        } else if (first == "end") {
+            if (!in_profile) throw runtime_error("Unexpected 'end' at " + location);
+            in_profile = false;
         } else {
-            if (elem.type == "mux") {
-                getline(file, line);
-                stringstream conn_stream(line);
-                float conn;
-                while (conn_stream >> conn) {
-                    elem.connections.push_back(conn);
-                }
-                // Ler conexões específicas para mux
-                getline(file, line);
-                stringstream sel_stream(line);
-                while (sel_stream >> conn) {
-                    elem.selectors.push_back(conn);
-                }
-            } else {
-                for (int i = elem.type == "out" ? 0 : 1; i < num_inputs; ++i) {
-                    getline(file, line);
-                    stringstream conn_stream(line);
-                    float conn;
-                    while (conn_stream >> conn) {
-                        elem.connections.push_back(conn);
-                    }
+            if (!in_profile) throw runtime_error("Input assignment outside a profile at " + location);
+            ProfileEntry entry;
+            entry.ref = first;
+            if (!(ss >> entry.prob_0 >> entry.prob_1) || entry.prob_0 < 0 || entry.prob_0 > 1 || entry.prob_1 < 0 || entry.prob_1 > 1) {
+                throw runtime_error("Invalid input probabilities at " + location);
+            }
+            profiles.back().entries.push_back(entry);
+        }
+    }
+    if (in_profile) {
+        throw runtime_error("Profile '" + profiles.back().name + "' in " + filename + " has no 'end'");
+    }
+
+    return profiles;
+}
+
+
+
+
+
+// Função para criar um lote com um cenário por perfil, resolvendo as referências nas entradas da netlist
+ScenarioBatch createProfileBatch(const Netlist& netlist, const vector<ProbabilityProfile>& profiles) {
+    ScenarioBatch batch = createScenarioBatch(netlist, profiles.size());
+
+    // Índice das entradas por ID e por nome, construído uma única vez para todos os perfis
+    unordered_map<string, int> input_by_ref;
+    vector<int> inputs;
+    for (size_t node = 0; node < netlist.size(); ++node) {
+        if (netlist.ops[node] != OP_INPT) continue;
+        inputs.push_back(node);
+        input_by_ref[to_string(netlist.ids[node])] = node;
+        if (!netlist.name(node).empty()) input_by_ref["//" + string(netlist.name(node))] = node;
+    }
+
+    for (size_t k = 0; k < profiles.size(); ++k) {
+        batch.names.push_back(profiles[k].name);
+        for (const auto& entry : profiles[k].entries) {
+            if (entry.ref == "*") {
+                for (int node : inputs) {
+                    batch.p0(node)[k] = entry.prob_0;
+                    batch.p1(node)[k] = entry.prob_1;
                 }
+                continue;
+            }
+            const auto it = input_by_ref.find(entry.ref);
+            if (it == input_by_ref.end()) {
+                cerr << "Warning: Profile '" << profiles[k].name << "' references unknown input " << entry.ref << endl;
+                continue;
             }
+            batch.p0(it->second)[k] = entry.prob_0;
+            batch.p1(it->second)[k] = entry.prob_1;
         }
-
-        netlist[elem.id] = elem;
     }
 
-    file.close();
+    return batch;
 }
 
 
 
 
 
-// Função para calcular probabilidades para portas lógicas e elementos especiais
-void calculateElementProbability(map<int, Element>& netlist, Element& elem) {
-    for (auto& [id, elem] : netlist) {
-        if (elem.connections.size() >= 1) {
-            const Element& input1 = netlist.at(elem.connections[0]);
-            if (elem.type == "not") {
-                elem.prob_0 = input1.prob_1;
-                elem.prob_1 = input1.prob_0;
-            } else if (elem.connections.size() >= 2) {
-                const Element& input2 = netlist.at(elem.connections[1]);
-                if (elem.type == "and") {
-                    elem.prob_1 = input1.prob_1 * input2.prob_1;
-                    elem.prob_0 = input1.prob_0 + input2.prob_0 - (input1.prob_0 * input2.prob_0);
-                } else if (elem.type == "or") {
-                    elem.prob_1 = input1.prob_1 + input2.prob_1 - (input1.prob_1 * input2.prob_1);
-                    elem.prob_0 = input1.prob_0 * input2.prob_0;
-                } else if (elem.type == "xor") {
-                    elem.prob_0 = input1.prob_0 * input2.prob_0 + input1.prob_1 * input2.prob_1;
-                    elem.prob_1 = input1.prob_0 * input2.prob_1 + input1.prob_1 * input2.prob_0;
-                } else if (elem.type == "nand") {
-                    elem.prob_0 = input1.prob_1 * input2.prob_1;
-                    elem.prob_1 = input1.prob_0 + input2.prob_0 - (input1.prob_0 * input2.prob_0);
-                } else if (elem.type == "nor") {
-                    elem.prob_0 = input1.prob_1 + input2.prob_1 - (input1.prob_1 * input2.prob_1);
-                    elem.prob_1 = input1.prob_0 * input2.prob_0;
-                } else if (elem.type == "xnor") {
-                    elem.prob_0 = input1.prob_0 * input2.prob_1 + input1.prob_1 * input2.prob_0;
-                    elem.prob_1 = input1.prob_0 * input2.prob_0 + input1.prob_1 * input2.prob_1;
-                }
-            }
-
-            if (elem.type == "mux" && elem.connections.size() >= 2 && elem.selectors.size() >= 1) {
-                int in_a = elem.connections[0];
-                int in_b = elem.connections[1];
-                int sel_c = elem.selectors[0];
-
-                const Element& input_a = netlist.at(in_a);
-                const Element& input_b = netlist.at(in_b);
-                const Element& selector_c = netlist.at(sel_c);
+// Função para salvar as probabilidades das entradas e das saídas de todos os cenários de um lote
+void saveBatchProbabilities(const Netlist& netlist, const ScenarioBatch& batch, const string& output_filename, string source_directory) {
+    ScopedTimer timer("write_batch");
+    // Diretório onde o arquivo será salvo
+    const std::string directory = source_directory + "/Batch/";
+    
+    // Verifica se o diretório existe, caso contrário, cria-o
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directory(directory);
+    }
 
-                // Cálculo da porta NOT para ~C
-                double prob_c_0 = selector_c.prob_1;
-                double prob_c_1 = selector_c.prob_0;
+    // Caminho completo para o arquivo
+    const std::string file_path = directory + output_filename + ".txt";
 
-                // Cálculo das portas AND para AC e B~C
-                double prob_ac_1 = input_a.prob_1 * selector_c.prob_1;
-                double prob_ac_0 = input_a.prob_0 + selector_c.prob_0 - (input_a.prob_0 * selector_c.prob_0);
+    // Abre o arquivo para escrita
+    ofstream output_file(file_path);
 
-                double prob_bnc_1 = input_b.prob_1 * prob_c_0;
-                double prob_bnc_0 = input_b.prob_0 + prob_c_1 - (input_b.prob_0 * prob_c_1);
+    if (!output_file.is_open()) {
+        cerr << "Error opening file " << output_filename << " for writing!" << endl;
+        return;
+    }
 
-                // Cálculo da porta OR para AC + B~C
-                elem.prob_1 = prob_ac_1 + prob_bnc_1 - (prob_ac_1 * prob_bnc_1);
-                elem.prob_0 = prob_ac_0 * prob_bnc_0;
+    for (size_t k = 0; k < batch.scenarios; ++k) {
+        output_file << "Scenario " << k;
+        if (k < batch.names.size()) output_file << " (" << batch.names[k] << ")";
+        output_file << ":\n  Inputs:";
+        for (size_t node = 0; node < netlist.size(); ++node) {
+            if (netlist.ops[node] == OP_INPT) {
+                output_file << " " << netlist.ids[node] << " (0: " << batch.p0(node)[k] << "; 1: " << batch.p1(node)[k] << ")";
+            }
+        }
+        output_file << "\n";
+        for (size_t node = 0; node < netlist.size(); ++node) {
+            if (netlist.ops[node] == OP_OUT) {
+                output_file << "  Output " << netlist.ids[node] << " (0: " << batch.p0(node)[k] << "; 1: " << batch.p1(node)[k] << ")\n";
             }
+        }
+        output_file << "\n";
+    }
 
-            if (elem.type == "sum_sub" && elem.connections.size() >= 3 && elem.selectors.size() >= 1) {
-                int in_a = elem.connections[0];  // Entrada A
-                int in_b = elem.connections[1];  // Entrada B
-                int in_cin = elem.connections[2];  // Carry-in
-                int op = elem.selectors[0];  // Operador (Op)
+    timer.addBytes(output_file.tellp());
+    output_file.close();
+}
 
-                const Element& input_a = netlist.at(in_a);
-                const Element& input_b = netlist.at(in_b);
-                const Element& input_cin = netlist.at(in_cin);
-                const Element& input_op = netlist.at(op);
 
-                // Probabilidades NOT para ~A, ~B, ~Cin e ~Op
-                double prob_a_0 = input_a.prob_0;
-                double prob_a_1 = input_a.prob_1;
 
-                double prob_b_0 = input_b.prob_0;
-                double prob_b_1 = input_b.prob_1;
 
-                double prob_cin_0 = input_cin.prob_0;
-                double prob_cin_1 = input_cin.prob_1;
 
-                double prob_op_0 = input_op.prob_0;
-                double prob_op_1 = input_op.prob_1;
 
-                // Cálculo para o Termo 1: A AND ~B AND ~Cin
-                double prob_not_b_0 = prob_b_1;
-                double prob_not_b_1 = prob_b_0;
+// Pool de threads com roubo de trabalho: cada thread consome a própria fila pelo fim e, quando ela esvazia,
+// rouba tarefas do início da fila de outra thread; assim tarefas de custos muito diferentes (netlists de
+// tamanhos variados) se equilibram entre os núcleos
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned num_threads) : queues_(max(1u, num_threads)) {}
 
-                double prob_and_a_not_b_1 = prob_a_1 * prob_not_b_1;
-                double prob_and_a_not_b_0 = prob_a_0 + prob_not_b_0 - (prob_a_0 * prob_not_b_0);
+    // Executa task(i) para todo i em [0, count) e retorna quando todas as tarefas terminarem
+    void run(size_t count, const function<void(size_t)>& task) {
+        const size_t num_threads = min(queues_.size(), max<size_t>(count, 1));
+        for (size_t i = 0; i < count; ++i) queues_[i % num_threads].tasks.push_back(i);
 
-                double prob_t1_1 = prob_and_a_not_b_1 * prob_cin_1;
-                double prob_t1_0 = prob_and_a_not_b_0 + prob_cin_0 - (prob_and_a_not_b_0 * prob_cin_0);
+        auto worker = [&](size_t self) {
+            size_t index;
+            while (popOwn(self, index) || steal(self, num_threads, index)) task(index);
+        };
+        vector<thread> threads;
+        for (size_t t = 1; t < num_threads; ++t) threads.emplace_back(worker, t);
+        worker(0);
+        for (auto& t : threads) t.join();
+    }
 
-                // Cálculo para o Termo 2: A AND B AND Cin
-                double prob_and_a_b_1 = prob_a_1 * prob_b_1;
-                double prob_and_a_b_0 = prob_a_0 + prob_b_0 - (prob_a_0 * prob_b_0);
+private:
+    struct Queue {
+        mutex lock;
+        deque<size_t> tasks;
+    };
+
+    bool popOwn(size_t self, size_t& index) {
+        lock_guard<mutex> guard(queues_[self].lock);
+        if (queues_[self].tasks.empty()) return false;
+        index = queues_[self].tasks.back();
+        queues_[self].tasks.pop_back();
+        return true;
+    }
 
-                double prob_t2_1 = prob_and_a_b_1 * prob_cin_1;
-                double prob_t2_0 = prob_and_a_b_0 + prob_cin_0 - (prob_and_a_b_0 * prob_cin_0);
+    bool steal(size_t self, size_t num_threads, size_t& index) {
+        for (size_t k = 1; k < num_threads; ++k) {
+            Queue& victim = queues_[(self + k) % num_threads];
+            lock_guard<mutex> guard(victim.lock);
+            if (victim.tasks.empty()) continue;
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
 
-                // Cálculo para o Termo 3: ~A AND ~B AND Cin
-                double prob_not_a_0 = prob_a_1;
-                double prob_not_a_1 = prob_a_0;
+    vector<Queue> queues_;
+};
 
-                double prob_and_not_a_not_b_1 = prob_not_a_1 * prob_not_b_1;
-                double prob_and_not_a_not_b_0 = prob_not_a_0 + prob_not_b_0 - (prob_not_a_0 * prob_not_b_0);
+// Função para ler a lista de netlists suspeitas (um caminho por linha; linhas em branco e '#' ignoradas)
+vector<string> parseSuspectList(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open suspect list " + filename);
+    }
 
-                double prob_t3_1 = prob_and_not_a_not_b_1 * prob_cin_1;
-                double prob_t3_0 = prob_and_not_a_not_b_0 + prob_cin_0 - (prob_and_not_a_not_b_0 * prob_cin_0);
+    vector<string> suspects;
+    string line;
+    while (getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') continue;
+        suspects.push_back(line);
+    }
+    return suspects;
+}
 
-                // Cálculo para o Termo 4: ~A AND B AND ~Cin
-                double prob_and_not_a_b_1 = prob_not_a_1 * prob_b_1;
-                double prob_and_not_a_b_0 = prob_not_a_0 + prob_b_0 - (prob_not_a_0 * prob_b_0);
+// Função para comparar uma netlist de referência com várias suspeitas
+// A referência é lida e propagada uma única vez; as suspeitas são processadas em
+// paralelo no pool e o relatório de cada uma é gravado em Divergences/Suspect_<n>_<nome>.txt assim que ela termina.
+// Ao final grava Divergences/Suspects_Summary.txt com a quantidade de divergências (ou o erro) de cada suspeita
+void compareSuspects(const string& golden_filename, const vector<string>& suspects, bool exact, const ExactOptions& exact_options,
+                     const DivergenceOptions& divergence_options, unsigned num_threads, const string& source_directory) {
+    Netlist golden;
+    parseNetlist(golden_filename, golden);
+    calculateProbabilities(golden);
+    if (exact) calculateExactProbabilities(golden, exact_options);
+
+    const std::string directory = source_directory + "/Divergences";
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directories(directory);
+    }
 
-                double prob_t4_1 = prob_and_not_a_b_1 * prob_cin_1;
-                double prob_t4_0 = prob_and_not_a_b_0 + prob_cin_0 - (prob_and_not_a_b_0 * prob_cin_0);
+    // Resultado de cada suspeita: quantidade de divergências ou mensagem de erro
+    vector<string> summary(suspects.size());
+    mutex output_lock;
+    size_t finished = 0;
+    const int width = to_string(suspects.size()).size();
+
+    WorkStealingPool pool(num_threads);
+    pool.run(suspects.size(), [&](size_t k) {
+        stringstream report_name;
+        report_name << "Suspect_" << setw(width) << setfill('0') << k + 1 << "_" << std::filesystem::path(suspects[k]).stem().string();
+
+        string result;
+        try {
+            Netlist suspect;
+            if (!std::filesystem::is_regular_file(suspects[k])) throw runtime_error("could not open file");
+            parseNetlist(suspects[k], suspect);
+            calculateProbabilities(suspect);
+            if (exact) calculateExactProbabilities(suspect, exact_options);
+
+            const DivergenceReport divergences = compareProbabilities(golden, suspect, divergence_options);
+            saveDivergences(divergences, golden, suspect, source_directory, report_name.str());
+            result = to_string(divergences.divergent) + " divergence(s)";
+        } catch (const exception& e) {
+            result = string("error: ") + e.what();
+        }
 
-                // Combinação dos Termos 1 e 2 com OR
-                double prob_partial1_1 = prob_t1_1 + prob_t2_1 - (prob_t1_1 * prob_t2_1);
-                double prob_partial1_0 = prob_t1_0 * prob_t2_0;
+        lock_guard<mutex> guard(output_lock);
+        summary[k] = result;
+        cout << "[" << ++finished << "/" << suspects.size() << "] " << suspects[k] << ": " << result << endl;
+    });
 
-                // Combinação dos Termos 3 e 4 com OR
-                double prob_partial2_1 = prob_t3_1 + prob_t4_1 - (prob_t3_1 * prob_t4_1);
-                double prob_partial2_0 = prob_t3_0 * prob_t4_0;
+    ofstream summary_file(directory + "/Suspects_Summary.txt");
+    summary_file << "Golden netlist: " << golden_filename << "\n";
+    for (size_t k = 0; k < suspects.size(); ++k) {
+        summary_file << suspects[k] << ": " << summary[k] << "\n";
+    }
+}
 
-                // Resultado final para a saída principal (out)
-                elem.prob_1 = prob_partial1_1 + prob_partial2_1 - (prob_partial1_1 * prob_partial2_1);
-                elem.prob_0 = prob_partial1_0 * prob_partial2_0;
 
-                // Cálculos intermediários para o carry-out
-                // Termo 1: B AND Cin
-                double prob_and_b_cin_1 = prob_b_1 * prob_cin_1;
-                double prob_and_b_cin_0 = prob_b_0 + prob_cin_0 - (prob_b_0 * prob_cin_0);
 
-                // Termo 2: ~Op AND A AND Cin
-                double prob_not_op_1 = prob_op_0;
-                double prob_not_op_0 = prob_op_1;
 
-                double prob_and_not_op_a_1 = prob_not_op_1 * prob_a_1;
-                double prob_and_not_op_a_0 = prob_not_op_0 + prob_a_0 - (prob_not_op_0 * prob_a_0);
 
-                double prob_term2_1 = prob_and_not_op_a_1 * prob_cin_1;
-                double prob_term2_0 = prob_and_not_op_a_0 + prob_cin_0 - (prob_and_not_op_a_0 * prob_cin_0);
+// Relatórios que um trabalho do manifesto pode gravar
+enum ReportFlags : uint32_t {
+    REPORT_PATHS = 1 << 0,       // Outputs/: listagem dos caminhos lógicos
+    REPORT_PATH_STATS = 1 << 1,  // Path_Stats/: estatísticas de caminhos
+    REPORT_DIVERGENCES = 1 << 2, // Divergences/: divergências entre referência e suspeita
+    REPORT_TRANSITIONS = 1 << 3, // Table_Transitions/: probabilidades de transição
+    REPORT_PROFILES = 1 << 4,    // Batch/Profiles_*: perfis de entrada (exige 'profiles')
+    REPORT_LOCALIZATION = 1 << 5, // Divergences/Localization.txt: pontos de divergência internos
+    REPORT_DEFAULT = REPORT_PATHS | REPORT_PATH_STATS | REPORT_DIVERGENCES | REPORT_TRANSITIONS | REPORT_PROFILES | REPORT_LOCALIZATION
+};
 
-                // Termo 3: Op AND ~A AND Cin
-                double prob_and_op_not_a_1 = prob_op_1 * prob_not_a_1;
-                double prob_and_op_not_a_0 = prob_op_0 + prob_not_a_0 - (prob_op_0 * prob_not_a_0);
+// Trabalho do manifesto: netlist de referência, suspeita opcional e relatórios a gravar em 'output'
+struct ManifestJob {
+    string name;
+    string golden;
+    string suspect;
+    string profiles;
+    string output;
+    uint32_t reports = REPORT_DEFAULT;
+};
 
-                double prob_term3_1 = prob_and_op_not_a_1 * prob_cin_1;
-                double prob_term3_0 = prob_and_op_not_a_0 + prob_cin_0 - (prob_and_op_not_a_0 * prob_cin_0);
+// Função para ler um manifesto de trabalhos
+// Formato (linhas iniciadas por '#' são comentários):
+//   job <nome>
+//   golden <netlist>
+//   suspect <netlist>                  (opcional; sem ela só os relatórios da referência são gravados)
+//   profiles <arquivo>                 (opcional)
+//   output <diretório>                 (padrão: ./Results/<nome>)
+//   reports <paths|stats|divergences|transitions|profiles|localize ...>   (padrão: todos)
+//   end
+vector<ManifestJob> parseManifest(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open manifest " + filename);
+    }
 
-                // Combinação dos Termos 1 e 2 com OR
-                double prob_partial_ct1_ct2_1 = prob_and_b_cin_1 + prob_term2_1 - (prob_and_b_cin_1 * prob_term2_1);
-                double prob_partial_ct1_ct2_0 = prob_and_b_cin_0 * prob_term2_0;
+    const map<string, uint32_t> report_names = {
+        {"paths", REPORT_PATHS}, {"stats", REPORT_PATH_STATS}, {"divergences", REPORT_DIVERGENCES},
+        {"transitions", REPORT_TRANSITIONS}, {"profiles", REPORT_PROFILES}, {"localize", REPORT_LOCALIZATION}
+    };
 
-                // Combinação do resultado com Termo 3 com OR
-                double prob_partial_ct1_1 = prob_partial_ct1_ct2_1 + prob_term3_1 - (prob_partial_ct1_ct2_1 * prob_term3_1);
-                double prob_partial_ct1_0 = prob_partial_ct1_ct2_0 * prob_term3_0;
+    vector<ManifestJob> jobs;
+    bool in_job = false;
+    string line;
+    int line_number = 0;
+    while (getline(file, line)) {
+        line_number++;
+        stringstream ss(line);
+        string first;
+        if (!(ss >> first) || first[0] == '#') {
+            continue; // Ignorar linhas em branco e comentários
+        }
 
-                // Termo 4: Op AND ~A AND B
-                double prob_and_op_not_a_1_step1 = prob_op_1 * prob_not_a_1;
-                double prob_and_op_not_a_0_step1 = prob_op_0 + prob_not_a_0 - (prob_op_0 * prob_not_a_0);
+        const string location = filename + ":" + to_string(line_number);
+        if (first == "job") {
+            if (in_job) throw runtime_error("Missing 'end' before new job at " + location);
+            ManifestJob job;
+            if (!(ss >> job.name)) throw runtime_error("Job without name at " + location);
+            jobs.push_back(job);
+            in_job = true;
+            continue;
+        }
+        if (!in_job) throw runtime_error("Job setting outside a job at " + location);
+
+        ManifestJob& job = jobs.back();
+        if (first == "end") {
+            if (job.golden.empty()) throw runtime_error("Job '" + job.name + "' has no golden netlist");
+            if (job.output.empty()) job.output = "./Results/" + job.name;
+            in_job = false;
+        } else if (first == "reports") {
+            job.reports = 0;
+            string report;
+            while (ss >> report) {
+                const auto it = report_names.find(report);
+                if (it == report_names.end()) throw runtime_error("Unknown report '" + report + "' at " + location);
+                job.reports |= it->second;
+            }
+        } else {
+            string value;
+            if (!(ss >> value)) throw runtime_error("Missing value for '" + first + "' at " + location);
+            if (first == "golden") job.golden = value;
+            else if (first == "suspect") job.suspect = value;
+            else if (first == "profiles") job.profiles = value;
+            else if (first == "output") job.output = value;
+            else throw runtime_error("Unknown job setting '" + first + "' at " + location);
+        }
+    }
+    if (in_job) {
+        throw runtime_error("Job '" + jobs.back().name + "' in " + filename + " has no 'end'");
+    }
 
-                double prob_term4_1 = prob_and_op_not_a_1_step1 * prob_b_1;
-                double prob_term4_0 = prob_and_op_not_a_0_step1 + prob_b_0 - (prob_and_op_not_a_0_step1 * prob_b_0);
+    return jobs;
+}
 
-                // Termo 5: ~Op AND A AND B
-                double prob_and_not_op_a_1_step1 = prob_not_op_1 * prob_a_1;
-                double prob_and_not_op_a_0_step1 = prob_not_op_0 + prob_a_0 - (prob_not_op_0 * prob_a_0);
+// Netlist lida e propagada uma única vez e compartilhada entre os trabalhos do manifesto
+// Caminhos e estatísticas são calculados na primeira vez que algum trabalho precisa deles
+struct PreparedNetlist {
+    Netlist netlist;
+    PathDag paths;
+    PathStats stats;
+    bool has_paths = false;
+    bool has_stats = false;
+
+    const PathDag& outputPaths() {
+        if (!has_paths) findPathsForOutputs(netlist, paths);
+        has_paths = true;
+        return paths;
+    }
+    const PathStats& pathStats() {
+        if (!has_stats) computePathStatistics(netlist, stats);
+        has_stats = true;
+        return stats;
+    }
+};
 
-                double prob_term5_1 = prob_and_not_op_a_1_step1 * prob_b_1;
-                double prob_term5_0 = prob_and_not_op_a_0_step1 + prob_b_0 - (prob_and_not_op_a_0_step1 * prob_b_0);
+// Função para executar todos os trabalhos de um manifesto em um único processo
+// Netlists citadas em vários trabalhos são lidas, propagadas e têm os caminhos calculados uma única vez.
+// Um erro em um trabalho é relatado no resumo sem interromper os demais; ao final imprime o tempo de cada trabalho
+// Retorna a quantidade de trabalhos com erro
+size_t runManifest(const vector<ManifestJob>& jobs, bool exact, const ExactOptions& exact_options, const DivergenceOptions& divergence_options) {
+    map<string, unique_ptr<PreparedNetlist>> cache;
+
+    // Retorna a netlist já preparada ou a lê e propaga; 'reused' indica se veio do cache
+    auto prepare = [&](const string& filename, bool& reused) -> PreparedNetlist& {
+        const string key = std::filesystem::weakly_canonical(filename).string();
+        auto& entry = cache[key];
+        reused = entry != nullptr;
+        if (!reused) {
+            if (!std::filesystem::is_regular_file(filename)) throw runtime_error("could not open " + filename);
+            auto prepared = make_unique<PreparedNetlist>();
+            parseNetlist(filename, prepared->netlist);
+            calculateProbabilities(prepared->netlist);
+            if (exact) calculateExactProbabilities(prepared->netlist, exact_options);
+            entry = move(prepared);
+        }
+        return *entry;
+    };
+
+    struct JobSummary {
+        long long time_us = 0;
+        string result;
+    };
+    vector<JobSummary> summary(jobs.size());
+    size_t failed = 0;
+
+    for (size_t k = 0; k < jobs.size(); ++k) {
+        const ManifestJob& job = jobs[k];
+        const auto start = std::chrono::high_resolution_clock::now();
+        try {
+            if (!std::filesystem::exists(job.output)) {
+                std::filesystem::create_directories(job.output);
+            }
 
-                // Combinação dos Termos 4 e 5 com OR
-                double prob_partial_ct2_1 = prob_term4_1 + prob_term5_1 - (prob_term4_1 * prob_term5_1);
-                double prob_partial_ct2_0 = prob_term4_0 * prob_term5_0;
+            bool golden_reused = false, suspect_reused = false;
+            PreparedNetlist& golden = prepare(job.golden, golden_reused);
+            PreparedNetlist* suspect = job.suspect.empty() ? nullptr : &prepare(job.suspect, suspect_reused);
 
-                // Resultado final para o carry-out
-                elem.carry_out_prob_1 = prob_partial_ct1_1 + prob_partial_ct2_1 - (prob_partial_ct1_1 * prob_partial_ct2_1);
-                elem.carry_out_prob_0 = prob_partial_ct1_0 * prob_partial_ct2_0;
-            }
-            if (elem.type == "out" && !elem.connections.empty()) {
-                double source_id = elem.connections[0];
-                const Element& source = netlist.at(source_id);
-                    
-                if(source.type == "sum_sub" && to_string(source_id).find(".2") != string::npos) {
-                    elem.prob_0 = source.carry_out_prob_0;
-                    elem.prob_1 = source.carry_out_prob_1;
-                } else {
-                    elem.prob_0 = source.prob_0;
-                    elem.prob_1 = source.prob_1;
+            // Relatórios de cada netlist do trabalho, com os mesmos nomes de arquivo do modo de par
+            auto writeNetlistReports = [&](PreparedNetlist& prepared, const string& suffix) {
+                if (job.reports & REPORT_PATHS) {
+                    displayOutputPaths(prepared.outputPaths(), prepared.netlist, suffix, job.output);
                 }
+                if (job.reports & REPORT_PATH_STATS) {
+                    savePathStatistics(prepared.pathStats(), prepared.outputPaths(), prepared.netlist, suffix, job.output);
+                }
+                if (job.reports & REPORT_TRANSITIONS) {
+                    saveTransitionProbabilities(prepared.netlist, "Prob" + suffix, job.output);
+                }
+            };
+            writeNetlistReports(golden, "_Netlist_Limpa");
+            if (suspect) writeNetlistReports(*suspect, "_Netlist_Trojan");
+
+            size_t divergence_count = 0;
+            if (suspect && (job.reports & REPORT_DIVERGENCES)) {
+                const DivergenceReport divergences = compareProbabilities(golden.netlist, suspect->netlist, divergence_options);
+                saveDivergences(divergences, golden.netlist, suspect->netlist, job.output);
+                divergence_count = divergences.divergent;
+            }
+            if (suspect && (job.reports & REPORT_LOCALIZATION)) {
+                saveLocalization(localizeDivergences(golden.netlist, suspect->netlist, divergence_options.match_depth), golden.netlist, suspect->netlist, job.output);
+            }
 
+            if (!job.profiles.empty() && (job.reports & REPORT_PROFILES)) {
+                const vector<ProbabilityProfile> profiles = parseProfiles(job.profiles);
+                if (!profiles.empty()) {
+                    ScenarioBatch batch = createProfileBatch(golden.netlist, profiles);
+                    calculateProbabilitiesBatch(golden.netlist, batch);
+                    saveBatchProbabilities(golden.netlist, batch, "Profiles_Netlist_Limpa", job.output);
+                    if (suspect) {
+                        ScenarioBatch suspect_batch = createProfileBatch(suspect->netlist, profiles);
+                        calculateProbabilitiesBatch(suspect->netlist, suspect_batch);
+                        saveBatchProbabilities(suspect->netlist, suspect_batch, "Profiles_Netlist_Trojan", job.output);
+                    }
+                }
             }
+
+            stringstream result;
+            if (suspect && (job.reports & REPORT_DIVERGENCES)) result << divergence_count << " divergence(s)";
+            else result << "ok";
+            const int reused = golden_reused + suspect_reused;
+            if (reused > 0) result << ", " << reused << " netlist(s) reused";
+            summary[k].result = result.str();
+        } catch (const exception& e) {
+            summary[k].result = string("error: ") + e.what();
+            failed++;
         }
+        const auto end = std::chrono::high_resolution_clock::now();
+        summary[k].time_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        cout << "[" << k + 1 << "/" << jobs.size() << "] " << job.name << ": " << summary[k].result << endl;
     }
-}
 
+    // Resumo com o tempo de cada trabalho
+    size_t name_width = 3;
+    for (const auto& job : jobs) name_width = max(name_width, job.name.size());
+    cout << "\n" << left << setw(name_width) << "Job" << "  " << right << setw(12) << "Time (us)" << "  Result\n";
+    for (size_t k = 0; k < jobs.size(); ++k) {
+        cout << left << setw(name_width) << jobs[k].name << "  " << right << setw(12) << summary[k].time_us << "  " << summary[k].result << "\n";
+    }
+    cout << "Distinct netlists prepared: " << cache.size() << endl;
+    return failed;
+}
 
 
 
 
-void calculateProbabilities(map<int, Element>& netlist) {
-    // Conjunto para armazenar elementos não processados na primeira passada
-    set<int> unresolved_elements;
 
-    // Primeira passada: tenta calcular as probabilidades para todos os elementos
-    for (auto& [id, elem] : netlist) {
-        if (elem.connections.size() >= 1) {
-            bool unresolved = false;
+// Parâmetros do gerador de netlists sintéticas
+struct GeneratorOptions {
+    size_t gates = 1000;          // Elementos lógicos (sem contar entradas, saídas e o trojan)
+    unsigned depth = 8;           // Níveis lógicos: cada elemento do nível L lê ao menos um elemento do nível L - 1
+    unsigned inputs = 32;
+    unsigned outputs = 16;
+    unsigned max_fanin = 2;       // Entradas das portas and/or/xor/nand/nor/xnor, sorteadas em [2, max_fanin]
+    double reconvergence = 0.1;   // Probabilidade de uma entrada extra vir do cone da primeira entrada (fanout reconvergente)
+    double fanout_skew = 0.2;     // Probabilidade de a fonte ser um "hub" (1/32 inicial do nível): fanout de cauda longa
+    double mux_rate = 0.05;       // Fração de mux
+    double sum_sub_rate = 0.05;   // Fração de sum_sub (metade das leituras de um sum_sub usa o carry-out ".2")
+    unsigned trojan_depth = 0;    // Nível do elemento vítima do trojan (0: depth / 2)
+    unsigned trigger_width = 8;   // Sinais comparados pelo gatilho do trojan (ativação rara: todos no valor sorteado)
+    uint64_t seed = 1;
+};
 
-            // Verifica se todas as conexões já foram processadas
-            for (int conn : elem.connections) {
-                if (netlist.at(conn).prob_0 == -1 || netlist.at(conn).prob_1 == -1) {
-                    unresolved = true;
-                    break;
-                }
-            }
+// Netlist sintética indexada por ID - 1, com as conexões em CSR referenciando IDs
+// As entradas vêm primeiro, depois os elementos nível a nível e as saídas; o trojan, se houver, fica no final
+struct SyntheticNetlist {
+    vector<uint8_t> ops;
+    vector<uint32_t> fanin_offset = {0};
+    vector<uint32_t> fanin;         // IDs das fontes
+    vector<uint8_t> fanin_pin;      // 2 para o carry-out de sum_sub, 0 nos demais casos
+    vector<string> names;           // Nomes ("//nome"); vazio para elementos internos sem nome
+    size_t clean_size = 0;          // Elementos da versão limpa (os seguintes são do trojan)
+    uint32_t victim = 0;            // ID do elemento vítima e da XOR de carga do trojan
+    uint32_t payload = 0;
+
+    uint32_t add(uint8_t op, const string& name = "") {
+        ops.push_back(op);
+        names.push_back(name);
+        fanin_offset.push_back(fanin.size());
+        return ops.size();
+    }
+    void connect(uint32_t source, uint8_t pin = 0) {
+        fanin.push_back(source);
+        fanin_pin.push_back(pin);
+        fanin_offset.back()++;
+    }
+};
 
-            // Se alguma conexão não foi resolvida, adicione o elemento ao conjunto de não resolvidos
-            if (unresolved) {
-                unresolved_elements.insert(id);
-                continue;
-            }
+// Função para gerar uma netlist sintética com a sua variante com trojan (gatilho comparador raro + XOR de carga)
+// O gatilho compara trigger_width sinais de níveis anteriores ao da vítima com um padrão sorteado (AND de sinais,
+// alguns invertidos); a carga é uma XOR entre a vítima e o gatilho que substitui a vítima em todos os seus leitores
+SyntheticNetlist generateNetlist(const GeneratorOptions& options) {
+    mt19937_64 rng(options.seed);
+    auto uniform = [&]() { return (rng() >> 11) * 0x1.0p-53; };
+    auto below = [&](size_t n) { return (size_t)(rng() % max<size_t>(n, 1)); };
+
+    SyntheticNetlist net;
+    const unsigned depth = max(1u, options.depth);
+    const size_t total = options.inputs + options.gates + options.outputs + 2 * options.trigger_width + 1;
+    net.ops.reserve(total);
+    net.names.reserve(total);
+    net.fanin_offset.reserve(total + 1);
+    net.fanin.reserve(total * (options.max_fanin + 1));
+    net.fanin_pin.reserve(total * (options.max_fanin + 1));
+
+    // level_begin[L]: primeiro ID do nível L (nível 0 = entradas)
+    vector<uint32_t> level_begin;
+    level_begin.push_back(1);
+    for (unsigned k = 0; k < max(1u, options.inputs); ++k) net.add(OP_INPT, "in" + to_string(k));
+
+    // Fonte de um elemento do nível L: em 3/4 dos casos do nível anterior, senão de qualquer nível anterior
+    auto pickSource = [&](unsigned level) {
+        const unsigned source_level = (rng() & 3) ? level - 1 : below(level);
+        const uint32_t begin = level_begin[source_level], end = level_begin[source_level + 1];
+        const size_t size = end - begin;
+        const size_t hubs = max<size_t>(1, size / 32);
+        return begin + (uint32_t)(uniform() < options.fanout_skew ? below(hubs) : below(size));
+    };
+    // Elementos ainda sem leitor, em ordem de criação: as entradas extras os consomem primeiro, evitando lógica morta
+    vector<uint8_t> read(total + 1, 0);
+    vector<uint32_t> unread;
+    size_t unread_cursor = 0;
+    auto connectSource = [&](uint32_t source) {
+        const bool carry = net.ops[source - 1] == OP_SUM_SUB && (rng() & 1);
+        net.connect(source, carry ? 2 : 0);
+        read[source] = 1;
+    };
+    auto nextUnread = [&]() -> uint32_t {
+        while (unread_cursor < unread.size() && read[unread[unread_cursor]]) ++unread_cursor;
+        return unread_cursor < unread.size() ? unread[unread_cursor] : 0;
+    };
+    // Entrada extra de um elemento: com probabilidade 'reconvergence', uma das fontes da primeira entrada;
+    // senão o elemento mais antigo ainda sem leitor, ou uma fonte sorteada
+    auto pickExtra = [&](unsigned level, uint32_t first) {
+        const uint32_t b = net.fanin_offset[first - 1], e = net.fanin_offset[first];
+        if (e > b && uniform() < options.reconvergence) return net.fanin[b + below(e - b)];
+        const uint32_t pending = nextUnread();
+        return pending ? pending : pickSource(level);
+    };
+
+    // Tamanho dos níveis: o último tem no máximo um elemento por saída e, descendo, cada nível tem no máximo o dobro
+    // do seguinte (para que todos tenham leitores) ou a divisão igual do que resta; o nível 1 absorve a sobra
+    const size_t last_count = depth > 1 ? max<size_t>(1, min<size_t>(options.outputs, options.gates / depth)) : options.gates;
+    vector<size_t> level_size(depth + 1, 0);
+    size_t remaining = options.gates - min(options.gates, last_count);
+    level_size[depth] = max<size_t>(1, last_count);
+    for (unsigned level = depth - 1; level >= 1; --level) {
+        level_size[level] = max<size_t>(1, level == 1 ? remaining : min(remaining / level, 2 * level_size[level + 1]));
+        remaining -= min(remaining, level_size[level]);
+    }
 
-            // Calcula as probabilidades normalmente
-            calculateElementProbability(netlist, elem);
+    const uint8_t basic_ops[] = {OP_AND, OP_OR, OP_XOR, OP_NAND, OP_NOR, OP_XNOR, OP_NOT};
+    for (unsigned level = 1; level <= depth; ++level) {
+        level_begin.push_back(net.ops.size() + 1);
+        for (uint32_t id = level_begin[level - 1]; id < level_begin[level]; ++id) unread.push_back(id);
+        // A primeira entrada percorre o nível anterior em ordem, fixando a profundidade
+        const uint32_t previous_begin = level_begin[level - 1], previous_size = level_begin[level] - previous_begin;
+        for (size_t g = 0; g < level_size[level]; ++g) {
+            const double r = uniform();
+            const uint8_t op = r < options.mux_rate ? static_cast<uint8_t>(OP_MUX)
+                             : r < options.mux_rate + options.sum_sub_rate ? static_cast<uint8_t>(OP_SUM_SUB)
+                             : basic_ops[below(size(basic_ops))];
+            const uint32_t first = g < previous_size ? previous_begin + g : pickSource(level);
+            net.add(op);
+            connectSource(first);
+            const size_t fanin = op == OP_NOT ? 1 : op == OP_MUX ? 3 : op == OP_SUM_SUB ? 4
+                               : 2 + below(max(2u, options.max_fanin) - 1);
+            for (size_t k = 1; k < fanin; ++k) connectSource(pickExtra(level, first));
+        }
+    }
+    level_begin.push_back(net.ops.size() + 1);
+
+    // Saídas: primeiro os elementos do último nível, depois os ainda sem leitor e, por fim, elementos sorteados
+    const uint32_t last_begin = level_begin[depth], gates_end = level_begin[depth + 1];
+    for (unsigned k = 0; k < options.outputs; ++k) {
+        const uint32_t pending = nextUnread();
+        const uint32_t source = last_begin + k < gates_end ? last_begin + k
+                              : pending ? pending : level_begin[1] + below(gates_end - level_begin[1]);
+        net.add(OP_OUT, "out" + to_string(k));
+        connectSource(source);
+    }
+    net.clean_size = net.ops.size();
+
+    // Trojan: vítima no nível escolhido, entre os elementos que alcançam alguma saída; gatilho com sinais de níveis
+    // anteriores, para não criar ciclos
+    vector<uint8_t> live(net.ops.size() + 1, 0);
+    for (uint32_t id = net.ops.size(); id >= 1; --id) {
+        if (net.ops[id - 1] != OP_OUT && !live[id]) continue;
+        for (uint32_t k = net.fanin_offset[id - 1]; k < net.fanin_offset[id]; ++k) live[net.fanin[k]] = 1;
+    }
+    const unsigned victim_level = min(depth, max(1u, options.trojan_depth ? options.trojan_depth : depth / 2));
+    const uint32_t victim_begin = level_begin[victim_level], victim_size = level_begin[victim_level + 1] - victim_begin;
+    net.victim = victim_begin + below(victim_size);
+    for (uint32_t k = 0; k < victim_size && !live[net.victim]; ++k) {
+        net.victim = victim_begin + (net.victim - victim_begin + 1) % victim_size;
+    }
+    vector<uint32_t> terms;
+    for (unsigned k = 0; k < max(1u, options.trigger_width); ++k) {
+        const uint32_t signal = level_begin[0] + below(level_begin[victim_level] - level_begin[0]);
+        if (rng() & 1) {
+            terms.push_back(net.add(OP_NOT, "trojan|cmp" + to_string(k)));
+            connectSource(signal);
+        } else {
+            terms.push_back(signal);
         }
     }
+    // Árvore de AND de duas entradas sobre os termos do comparador
+    for (size_t k = 0; terms.size() - k > 1; k += 2) {
+        terms.push_back(net.add(OP_AND, "trojan|trigger" + to_string(terms.size())));
+        net.connect(terms[k]);
+        net.connect(terms[k + 1]);
+    }
+    net.payload = net.add(OP_XOR, "trojan|payload");
+    net.connect(net.victim);
+    net.connect(terms.back());
+    return net;
+}
 
-    // Segunda passada: resolve os elementos que ficaram pendentes
-    while (!unresolved_elements.empty()) {
-        set<int> still_unresolved;
+// Função para gravar a netlist sintética no formato texto; com 'trojan', inclui o trojan e redireciona os
+// leitores da vítima para a XOR de carga
+void writeSyntheticNetlist(const SyntheticNetlist& net, const string& filename, bool trojan) {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error("Could not create " + filename);
+    }
 
-        for (int id : unresolved_elements) {
-            Element& elem = netlist.at(id);
-            bool unresolved = false;
+    const size_t count = trojan ? net.ops.size() : net.clean_size;
+    auto source_of = [&](size_t id, size_t k) -> uint32_t {
+        const uint32_t source = net.fanin[k];
+        return trojan && source == net.victim && id != net.payload && id <= net.clean_size ? net.payload : source;
+    };
 
-            // Verifica novamente as conexões
-            for (int conn : elem.connections) {
-                if (netlist.at(conn).prob_0 == -1 || netlist.at(conn).prob_1 == -1) {
-                    unresolved = true;
-                    break;
-                }
-            }
+    // Quantidade de leitores de cada elemento (campo "saídas" do cabeçalho)
+    vector<uint32_t> fanout(count + 1, 0);
+    for (size_t id = 1; id <= count; ++id) {
+        for (uint32_t k = net.fanin_offset[id - 1]; k < net.fanin_offset[id]; ++k) fanout[source_of(id, k)]++;
+    }
 
-            if (unresolved) {
-                still_unresolved.insert(id);
-            } else {
-                calculateElementProbability(netlist, elem);
+    string buffer;
+    char number[16];
+    auto append = [&](uint64_t value) {
+        const auto result = to_chars(number, number + sizeof(number), value);
+        buffer.append(number, result.ptr);
+    };
+    auto appendRef = [&](size_t id, uint32_t k) {
+        append(source_of(id, k));
+        if (net.fanin_pin[k] == 2) buffer += ".2";
+    };
+
+    for (size_t id = 1; id <= count; ++id) {
+        const uint8_t op = net.ops[id - 1];
+        const uint32_t begin = net.fanin_offset[id - 1], end = net.fanin_offset[id];
+        append(id);
+        buffer += ' ';
+        buffer += OP_NAMES[op];
+        buffer += ' ';
+        append(op == OP_OUT ? 0 : fanout[id]);
+        buffer += ' ';
+        append(end - begin);
+        if (!net.names[id - 1].empty()) {
+            buffer += " //";
+            buffer += net.names[id - 1];
+        }
+        buffer += '\n';
+        if (op == OP_MUX) {
+            // Mux: (A B) e seletor; sum_sub: (A B), carry_in e operando
+            buffer += '\t'; appendRef(id, begin); buffer += ' '; appendRef(id, begin + 1);
+            buffer += "\n\t"; appendRef(id, begin + 2); buffer += '\n';
+        } else if (op == OP_SUM_SUB) {
+            buffer += '\t'; appendRef(id, begin); buffer += ' '; appendRef(id, begin + 1);
+            buffer += "\n\t"; appendRef(id, begin + 2);
+            buffer += "\n\t"; appendRef(id, begin + 3); buffer += '\n';
+        } else if (end > begin) {
+            buffer += '\t';
+            for (uint32_t k = begin; k < end; ++k) {
+                if (k > begin) buffer += ' ';
+                appendRef(id, k);
             }
+            buffer += '\n';
         }
-
-        // Atualiza o conjunto de elementos não resolvidos
-        if (still_unresolved.size() == unresolved_elements.size()) {
-            throw runtime_error("Cyclic dependency detected in netlist");
+        if (buffer.size() >= (1 << 20)) {
+            file << buffer;
+            buffer.clear();
         }
-
-        unresolved_elements = move(still_unresolved);
     }
+    file << buffer;
 }
 
+// Função para gerar o par <prefixo>_limpo.txt / <prefixo>_trojan.txt
+void generateNetlistPair(const GeneratorOptions& options, const string& prefix) {
+    const SyntheticNetlist net = generateNetlist(options);
+    const auto directory = std::filesystem::path(prefix).parent_path();
+    if (!directory.empty()) std::filesystem::create_directories(directory);
+    writeSyntheticNetlist(net, prefix + "_limpo.txt", false);
+    writeSyntheticNetlist(net, prefix + "_trojan.txt", true);
+    cout << "Generated " << prefix << "_limpo.txt (" << net.clean_size << " elements) and " << prefix << "_trojan.txt ("
+         << net.ops.size() << " elements; victim " << net.victim << ", payload " << net.payload << ")" << endl;
+}
 
-
-
-// Função recursiva para rastrear todos os caminhos até uma saída
-void tracePaths(int current, const map<int, Element>& netlist, vector<int>& path, vector<vector<int>>& all_paths) {
-    path.push_back(current);
-
-    const auto& elem = netlist.at(current);
-    if (elem.type == "inpt") {
-        // Se for uma entrada, finalizar o caminho
-        all_paths.push_back(path);
-    } else {
-        // Continuar rastreando as conexões
-        for (int conn : elem.connections) {
-            tracePaths(conn, netlist, path, all_paths);
-        }
+// Função para criar um diretório temporário exclusivo desta execução (<temp>/<prefix>XXXXXX), para que execuções
+// simultâneas (ou de outros usuários) nunca leiam nem apaguem os arquivos umas das outras
+string createScratchDirectory(const string& prefix) {
+    const std::filesystem::path base = std::filesystem::temp_directory_path();
+#if defined(__unix__) || defined(__APPLE__)
+    string pattern = (base / (prefix + "XXXXXX")).string();
+    if (::mkdtemp(pattern.data())) return pattern;
+#endif
+    random_device random;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        const std::filesystem::path path = base / (prefix + to_string(random()) + "_" + to_string(attempt));
+        if (std::filesystem::create_directory(path)) return path.string();
     }
-
-    path.pop_back();
+    throw runtime_error("Could not create a temporary directory in " + base.string());
 }
 
+// Função para medir a vazão do parser de texto e do cache binário em uma netlist sintética de 'megabytes' MB
+void runParseBenchmark(size_t megabytes, uint64_t seed) {
+    const string scratch = createScratchDirectory("parse_benchmark_");
+    const string filename = scratch + "/parse_benchmark_netlist.txt";
+    cout << "Generating " << megabytes << " MB synthetic netlist in " << filename << "..." << endl;
+    GeneratorOptions options;
+    options.gates = (megabytes << 20) / 30; // ~30 bytes por elemento no formato texto
+    options.depth = 64;
+    options.seed = seed;
+    writeSyntheticNetlist(generateNetlist(options), filename, false);
+    const double size_mb = std::filesystem::file_size(filename) / 1048576.0;
+
+    auto seconds = [](auto start) {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    // Melhor de 3 leituras do texto (com a netlist já no cache de páginas do sistema): só a varredura dos registros
+    // e a leitura completa (varredura, montagem dos arrays densos e levelização)
+    Netlist netlist;
+    double best_scan = INFINITY, best_text = INFINITY;
+    for (int rep = 0; rep < 3; ++rep) {
+        auto start = std::chrono::high_resolution_clock::now();
+        const MappedFile text(filename);
+        NetlistRecords records;
+        NetlistScanner(text.data(), text.data() + text.size(), filename).scan(records);
+        best_scan = min(best_scan, seconds(start));
+
+        start = std::chrono::high_resolution_clock::now();
+        parseNetlistText(text, filename, netlist);
+        best_text = min(best_text, seconds(start));
+    }
 
+    const MappedFile text(filename);
+    const uint64_t text_hash = hashBytes(text.data(), text.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    saveNetlistCache(filename, netlist, text.size(), text_hash);
+    const double save_time = seconds(start);
+
+    double best_cache = INFINITY;
+    for (int rep = 0; rep < 3; ++rep) {
+        start = std::chrono::high_resolution_clock::now();
+        if (!loadNetlistCache(filename, netlist, text.size(), text_hash)) throw runtime_error("Benchmark cache could not be loaded");
+        best_cache = min(best_cache, seconds(start));
+    }
 
+    cout << fixed << setprecision(1);
+    cout << "Netlist: " << size_mb << " MB, " << netlist.size() << " elements, " << netlist.fanin.size() << " connections" << endl;
+    cout << "Text scan:   " << best_scan * 1e3 << " ms (" << size_mb / best_scan << " MB/s)" << endl;
+    cout << "Text parse:  " << best_text * 1e3 << " ms (" << size_mb / best_text << " MB/s)" << endl;
+    cout << "Cache write: " << save_time * 1e3 << " ms" << endl;
+    cout << "Cache load:  " << best_cache * 1e3 << " ms (" << size_mb / best_cache << " MB/s of source text)" << endl;
 
-
-// Função para rastrear todas as possibilidades para cada saída
-void findPathsForOutputs(const map<int, Element>& netlist, map<int, vector<vector<int>>>& output_paths) {
-    for (const auto& [id, elem] : netlist) {
-        if (elem.type == "out") {
-            vector<vector<int>> all_paths;
-            vector<int> path;
-            tracePaths(id, netlist, path, all_paths);
-            output_paths[id] = all_paths;
-        }
-    }
+    error_code error;
+    std::filesystem::remove_all(scratch, error);
 }
 
 
 
 
 
-// Função para exibir os caminhos das saídas
-void displayOutputPaths(const map<int, vector<vector<int>>>& output_paths, const map<int, Element>& netlist, string num, string source_directory) {
-    
-    // Diretório onde o arquivo será salvo
-    const std::string directory = "./" + source_directory + "/Outputs/";
-    
-    // Verifica se o diretório existe, caso contrário, cria-o
-    if (!std::filesystem::exists(directory)) {
-        std::filesystem::create_directory(directory);
-    }
+// Estatísticas das repetições de uma fase do benchmark, em microssegundos
+struct PhaseStats {
+    double median = 0, p95 = 0, mean = 0, stddev = 0, cv = 0, min = 0;
+};
 
-    // Caminho completo para o arquivo
-    const std::string file_path = directory + "Output" + num + ".txt";
+PhaseStats summarizeSamples(vector<double> samples) {
+    PhaseStats stats;
+    if (samples.empty()) return stats;
+    sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    stats.min = samples.front();
+    stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    stats.p95 = samples[min(n - 1, (size_t)ceil(0.95 * n) - 1)];
+    for (double x : samples) stats.mean += x;
+    stats.mean /= n;
+    for (double x : samples) stats.stddev += (x - stats.mean) * (x - stats.mean);
+    stats.stddev = sqrt(stats.stddev / n);
+    stats.cv = stats.mean > 0 ? 100.0 * stats.stddev / stats.mean : 0.0;
+    return stats;
+}
 
-    // Abre o arquivo para escrita
-    ofstream output_file(file_path);
+// Texto JSON com aspas e barras escapadas
+string jsonString(const string& text) {
+    string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out + "\"";
+}
 
-    if (!output_file.is_open()) {
-        cerr << "Error opening file for writing!" << endl;
-        return;
+// Função para medir cada fase do pipeline em todas as netlists de um diretório, dentro do próprio processo
+// <nome>_limpo.txt é comparada com <nome>_trojan.txt; as demais netlists são comparadas com elas mesmas.
+// Cada par roda 'warmup' vezes sem medição e 'repetitions' vezes medidas; os relatórios vão para um diretório temporário.
+// Imprime mediana, p95 e CV de cada fase e grava tudo em JSON em json_filename
+void runBenchmark(const string& netlist_directory, size_t warmup, size_t repetitions, const string& json_filename) {
+    vector<pair<string, string>> pairs;
+    vector<string> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(netlist_directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") files.push_back(entry.path().string());
+    }
+    sort(files.begin(), files.end());
+    const set<string> file_set(files.begin(), files.end());
+    for (const string& file : files) {
+        const string clean_suffix = "_limpo.txt", trojan_suffix = "_trojan.txt";
+        if (file.size() > clean_suffix.size() && file.compare(file.size() - clean_suffix.size(), string::npos, clean_suffix) == 0) {
+            const string trojan = file.substr(0, file.size() - clean_suffix.size()) + trojan_suffix;
+            pairs.push_back({file, file_set.count(trojan) ? trojan : file});
+        } else if (file.size() <= trojan_suffix.size() || file.compare(file.size() - trojan_suffix.size(), string::npos, trojan_suffix) != 0
+                   || !file_set.count(file.substr(0, file.size() - trojan_suffix.size()) + clean_suffix)) {
+            pairs.push_back({file, file});
+        }
+    }
+    // Arquivos .txt que não são netlists válidas (ex: formatos antigos em subdiretórios) são avisados e ignorados
+    pairs.erase(remove_if(pairs.begin(), pairs.end(), [](const pair<string, string>& files) {
+        try {
+            for (const string& file : {files.first, files.second}) {
+                const MappedFile text(file);
+                Netlist netlist;
+                parseNetlistText(text, file, netlist);
+            }
+            return false;
+        } catch (const runtime_error& error) {
+            cerr << "Skipping " << files.first << ": " << error.what() << endl;
+            return true;
+        }
+    }), pairs.end());
+    if (pairs.empty()) {
+        throw runtime_error("No netlists found in " + netlist_directory);
     }
 
-    for (const auto& [output_id, paths] : output_paths) {
-        output_file << "Output " << output_id << ":\n";
-        int possibility_count = 1;
-        for (const auto& path : paths) {
-            output_file << "  Logical Path " << possibility_count++ << ": ";
-            for (size_t i = 0; i < path.size(); ++i) {
-                int node_id = path[i];
-                string node_representation = to_string(node_id);
-
-                // Verifica se o node_id tem sufixo e se o elemento é do tipo 'sum_sub'
-                if (i > 0) {
-                    int prev_node_id = path[i - 1];
-                    const auto& prev_elem = netlist.at(prev_node_id);
-                    const auto& elem = netlist.at(node_id);
-
-                    if (elem.type == "sum_sub") {
-                        // Verifica se o prev_elem está fazendo a conexão com o elemento atual
-                        // As conexões estão armazenadas em 'connections' no prev_elem
-                        for (const auto& connection : prev_elem.connections) {
-                            if (floor(connection) == node_id) {
-                                // Se a conexão for com o node_id atual, pegamos o valor da conexão
-                                stringstream ss;
-                                ss << fixed << setprecision(1) << connection;
-                                node_representation = ss.str();
-                                break;
-                            }
-                        }
-                    }
+    const string scratch = createScratchDirectory("transicao_benchmark_");
+    const vector<string> phases = {"parse_text", "parse_cache", "propagate", "paths", "compare",
+                                   "write_paths", "write_path_stats", "write_divergences", "write_transitions"};
+
+    stringstream json;
+    json << "{\n  \"compiler\": " << jsonString(__VERSION__) << ",\n  \"simd_lanes\": " << LaneVec::width
+         << ",\n  \"warmup\": " << warmup << ",\n  \"repetitions\": " << repetitions << ",\n  \"netlists\": [";
+
+    cout << left << setw(32) << "Netlist" << setw(20) << "Phase" << right << setw(12) << "Median (us)"
+         << setw(12) << "p95 (us)" << setw(9) << "CV (%)" << "\n";
+
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        const auto& [clean, trojan] = pairs[p];
+        map<string, vector<double>> samples;
+        Netlist netlist1, netlist2;
+
+        for (size_t rep = 0; rep < warmup + repetitions; ++rep) {
+            map<string, double> elapsed;
+            auto timed = [&](const string& phase, auto&& body) {
+                const auto start = std::chrono::high_resolution_clock::now();
+                body();
+                elapsed[phase] += std::chrono::duration<double, micro>(std::chrono::high_resolution_clock::now() - start).count();
+            };
+
+            // Leitura pelo texto e pelo cache binário (o cache é regravado fora da medição se estiver desatualizado)
+            uint64_t text_size[2], text_hash[2];
+            const string sources[2] = {clean, trojan};
+            for (int k = 0; k < 2; ++k) {
+                const MappedFile text(sources[k]);
+                text_size[k] = text.size();
+                text_hash[k] = hashBytes(text.data(), text.size());
+                Netlist& target = k == 0 ? netlist1 : netlist2;
+                timed("parse_text", [&] { parseNetlistText(text, sources[k], target); });
+            }
+            // Os caches ficam no diretório temporário, nunca ao lado das netlists medidas
+            const string cache_keys[2] = {scratch + "/Netlist_Limpa.txt", scratch + "/Netlist_Trojan.txt"};
+            for (int k = 0; k < 2; ++k) {
+                Netlist& target = k == 0 ? netlist1 : netlist2;
+                Netlist cached;
+                if (!loadNetlistCache(cache_keys[k], cached, text_size[k], text_hash[k])) {
+                    saveNetlistCache(cache_keys[k], target, text_size[k], text_hash[k]);
                 }
+                timed("parse_cache", [&] { loadNetlistCache(cache_keys[k], target, text_size[k], text_hash[k]); });
+            }
 
-                const Element& elem = netlist.at(node_id);
-
-                // Verifica se o node_representation contém o sufixo ".2" para escolher qual probabilidade exibir
-                if (node_representation.find(".2") != string::npos) {
-                    output_file << node_representation << " (0: " << elem.carry_out_prob_0 << "; 1: " << elem.carry_out_prob_1 << ")";
-                } else {
-                    output_file << node_representation << " (0: " << elem.prob_0 << "; 1: " << elem.prob_1 << ")";
-                }
-                
-                if (i < path.size() - 1) {
-                    output_file << " <- ";
-                }
+            PathDag paths1, paths2;
+            PathStats stats1, stats2;
+            DivergenceReport divergences;
+            timed("propagate", [&] { calculateProbabilities(netlist1); calculateProbabilities(netlist2); });
+            timed("paths", [&] { findPathsForOutputs(netlist1, paths1); findPathsForOutputs(netlist2, paths2); });
+            timed("compare", [&] { divergences = compareProbabilities(netlist1, netlist2); });
+            timed("write_paths", [&] {
+                displayOutputPaths(paths1, netlist1, "_Netlist_Limpa", scratch);
+                displayOutputPaths(paths2, netlist2, "_Netlist_Trojan", scratch);
+            });
+            timed("write_path_stats", [&] {
+                computePathStatistics(netlist1, stats1);
+                computePathStatistics(netlist2, stats2);
+                savePathStatistics(stats1, paths1, netlist1, "_Netlist_Limpa", scratch);
+                savePathStatistics(stats2, paths2, netlist2, "_Netlist_Trojan", scratch);
+            });
+            timed("write_divergences", [&] { saveDivergences(divergences, netlist1, netlist2, scratch); });
+            timed("write_transitions", [&] {
+                saveTransitionProbabilities(netlist1, "Prob_Netlist_Limpa", scratch);
+                saveTransitionProbabilities(netlist2, "Prob_Netlist_Trojan", scratch);
+            });
+
+            if (rep >= warmup) {
+                for (const auto& [phase, us] : elapsed) samples[phase].push_back(us);
             }
-            output_file << "\n";
         }
-        output_file << "\n"; // Linha em branco entre saídas
+
+        // Caminho relativo ao diretório, sem extensão (netlists com o mesmo nome em subdiretórios não se confundem)
+        const string name = std::filesystem::path(clean).lexically_relative(netlist_directory).replace_extension().generic_string();
+        json << (p ? "," : "") << "\n    {\n      \"name\": " << jsonString(name) << ",\n      \"clean\": " << jsonString(clean)
+             << ",\n      \"trojan\": " << jsonString(trojan) << ",\n      \"elements\": [" << netlist1.size() << ", " << netlist2.size()
+             << "],\n      \"phases\": {";
+        for (size_t k = 0; k < phases.size(); ++k) {
+            const PhaseStats stats = summarizeSamples(samples[phases[k]]);
+            json << (k ? "," : "") << "\n        " << jsonString(phases[k]) << ": {\"median_us\": " << stats.median << ", \"p95_us\": " << stats.p95
+                 << ", \"mean_us\": " << stats.mean << ", \"min_us\": " << stats.min << ", \"stddev_us\": " << stats.stddev << ", \"cv_percent\": " << stats.cv << "}";
+            cout << left << setw(32) << (k == 0 ? name : "") << setw(20) << phases[k] << right << fixed << setprecision(1)
+                 << setw(12) << stats.median << setw(12) << stats.p95 << setw(9) << stats.cv << "\n";
+        }
+        json << "\n      }\n    }";
+        cout.unsetf(ios::floatfield);
     }
+    json << "\n  ]\n}\n";
 
-    output_file.close(); // Fecha o arquivo
+    error_code error;
+    std::filesystem::remove_all(scratch, error);
+
+    const auto json_directory = std::filesystem::path(json_filename).parent_path();
+    if (!json_directory.empty()) std::filesystem::create_directories(json_directory);
+    ofstream json_file(json_filename);
+    if (!json_file.is_open()) {
+        cerr << "Error opening file " << json_filename << " for writing!" << endl;
+        return;
+    }
+    json_file << json.str();
+    cout << "Results written to " << json_filename << endl;
 }
 
 
 
 
 
-// Função para comparar as probabilidades e identificar divergências
-vector<string> compareProbabilitiesWithPaths(
-    const map<int, Element>& netlist1, const map<int, Element>& netlist2,
-    const map<int, vector<vector<int>>>& output_paths1, const map<int, vector<vector<int>>>& output_paths2) {
-    
-    vector<string> divergences;
-    const double epsilon = 1e-9;
-
-    // Listas de saídas que ainda não encontraram um par
-    // Como os 'output_paths' são maps, as listas já estarão ordenadas por ID
-    list<pair<int, const vector<vector<int>>*>> unmatched1, unmatched2;
-    for (const auto& [id, paths] : output_paths1) unmatched1.push_back({id, &paths});
-    for (const auto& [id, paths] : output_paths2) unmatched2.push_back({id, &paths});
-
-    // --- ETAPA ÚNICA: Comparar pares ordenados ---
-    // Itera pelas duas listas, comparando o primeiro de netlist1 com o primeiro de netlist2,
-    // o segundo com o segundo, e assim por diante.
-    while (!unmatched1.empty() && !unmatched2.empty()) {
-        const auto& out1 = unmatched1.front();
-        const auto& out2 = unmatched2.front();
-        const auto& elem1 = netlist1.at(out1.first);
-        const auto& elem2 = netlist2.at(out2.first);
-
-        // Verifica se as probabilidades do par atual são idênticas
-        if (abs(elem1.prob_0 - elem2.prob_0) < epsilon && abs(elem1.prob_1 - elem2.prob_1) < epsilon) {
-            // PAR ENCONTRADO! (Idêntico)
-            // As probabilidades são iguais, então não há divergência a relatar.
-        } else {
-            // PAR DIVERGENTE!
-            // As probabilidades são diferentes, relata a divergência.
-            stringstream ss;
-            ss << "Divergent Output: Output " << out1.first << " from Netlist 1 (Prob 0: " << elem1.prob_0 << ", Prob 1: " << elem1.prob_1 
-               << ") diverges from Output " << out2.first << " from Netlist 2 (Prob 0: " << elem2.prob_0 << ", Prob 1: " << elem2.prob_1 << ").\n";
-            divergences.push_back(ss.str());
-            divergences.push_back("----------------------------------------------------------------------------------------------\n");
-        }
+// Função para imprimir a instrumentação acumulada (--stats) e/ou gravá-la em JSON (--stats-json F)
+// Os tempos das fases aninhadas (ex: "levelize" dentro de "parse") também estão incluídos no tempo da fase externa
+void reportInstrumentation(bool print, const string& json_filename) {
+    if (!instrumentation.enabled) return;
+    lock_guard<mutex> guard(instrumentation.lock);
+    const uint64_t peak_rss = peakResidentBytes();
+    uint64_t gates = 0;
+    for (uint64_t count : instrumentation.gates_by_op) gates += count;
 
-        // Remove ambos os elementos da frente para processar o próximo par
-        unmatched1.pop_front();
-        unmatched2.pop_front();
+    if (print) {
+        cout << left << setw(20) << "Phase" << right << setw(8) << "Calls" << setw(14) << "Total (ms)" << setw(14) << "Bytes" << setw(12) << "Allocs" << "\n";
+        for (const PhaseCounter& phase : instrumentation.phases) {
+            cout << left << setw(20) << phase.name << right << setw(8) << phase.calls << fixed << setprecision(3)
+                 << setw(14) << phase.total_ms << setw(14);
+            cout.unsetf(ios::floatfield);
+            if (phase.bytes > 0) cout << phase.bytes; else cout << "-";
+            cout << setw(12) << phase.allocations << "\n";
+        }
+        cout << "Gates evaluated: " << gates;
+        const char* separator = " (";
+        for (int op = 0; op <= OP_UNKNOWN; ++op) {
+            if (instrumentation.gates_by_op[op] == 0) continue;
+            cout << separator << OP_NAMES[op] << " " << instrumentation.gates_by_op[op];
+            separator = ", ";
+        }
+        cout << (gates > 0 ? ")\n" : "\n");
+        cout << "Paths enumerated: " << instrumentation.paths_enumerated << "\n";
+        if (instrumentation.macro_cache_hits + instrumentation.macro_cache_misses > 0) {
+            cout << "Macro cache: " << instrumentation.macro_cache_hits << " hits, " << instrumentation.macro_cache_misses << " misses\n";
+        }
+        cout << "Bytes written: " << instrumentation.bytes_written << "\n";
+        cout << "Heap allocations: " << heap_counters.allocations.load() << " (peak " << fixed << setprecision(1)
+             << heap_counters.peak_bytes.load() / 1048576.0 << " MB)\n";
+        cout << "Peak RSS: " << peak_rss / 1048576.0 << " MB" << endl;
+        cout.unsetf(ios::floatfield);
     }
 
-    // Caso 2b: A Netlist 1 tem saídas extras que não possuem par na Netlist 2.
-    for (const auto& out1 : unmatched1) {
-        const auto& elem1 = netlist1.at(out1.first);
-        stringstream ss;
-        ss << "Unmatched Output: Output " << out1.first << " from Netlist 1 (Prob 0: " << elem1.prob_0 << ", Prob 1: " << elem1.prob_1
-           << ") has no equivalent in Netlist 2.\n";
-        divergences.push_back(ss.str());
-        divergences.push_back("----------------------------------------------------------------------------------------------\n");
+    if (json_filename.empty()) return;
+    const auto json_directory = std::filesystem::path(json_filename).parent_path();
+    if (!json_directory.empty()) std::filesystem::create_directories(json_directory);
+    ofstream json(json_filename);
+    if (!json.is_open()) {
+        cerr << "Error opening file " << json_filename << " for writing!" << endl;
+        return;
     }
-
-    // Caso 2c: A Netlist 2 tem saídas extras que não possuem par na Netlist 1.
-    for (const auto& out2 : unmatched2) {
-        const auto& elem2 = netlist2.at(out2.first);
-        stringstream ss;
-        ss << "Unmatched Output: Output " << out2.first << " from Netlist 1 (Prob 0: " << elem2.prob_0 << ", Prob 1: " << elem2.prob_1 
-           << ") has no equivalent in Netlist 1.\n";
-        divergences.push_back(ss.str());
-        divergences.push_back("----------------------------------------------------------------------------------------------\n");
+    json << "{\n  \"phases\": [";
+    for (size_t k = 0; k < instrumentation.phases.size(); ++k) {
+        const PhaseCounter& phase = instrumentation.phases[k];
+        json << (k ? "," : "") << "\n    {\"name\": " << jsonString(phase.name) << ", \"calls\": " << phase.calls
+             << ", \"total_ms\": " << phase.total_ms << ", \"bytes\": " << phase.bytes << ", \"allocations\": " << phase.allocations << "}";
     }
-
-    if (!divergences.empty()) {
-        divergences.back().pop_back();
+    json << "\n  ],\n  \"gates_evaluated\": {\"total\": " << gates;
+    for (int op = 0; op <= OP_UNKNOWN; ++op) {
+        if (instrumentation.gates_by_op[op] > 0) json << ", " << jsonString(OP_NAMES[op]) << ": " << instrumentation.gates_by_op[op];
     }
-
-    return divergences;
+    json << "},\n  \"paths_enumerated\": " << instrumentation.paths_enumerated
+         << ",\n  \"macro_cache\": {\"hits\": " << instrumentation.macro_cache_hits << ", \"misses\": " << instrumentation.macro_cache_misses
+         << "},\n  \"bytes_written\": " << instrumentation.bytes_written
+         << ",\n  \"heap\": {\"allocations\": " << heap_counters.allocations.load() << ", \"peak_bytes\": " << heap_counters.peak_bytes.load()
+         << "},\n  \"peak_rss_bytes\": " << peak_rss << "\n}\n";
 }
 
 
 
 
-// Função para criar o arquivo com as divergências entre as netlists
-void saveDivergences(const vector<string>& divergences, string source_directory) {
-    // Diretório onde o arquivo será salvo
-    const std::string directory = "./" + source_directory + "/Divergences";
-    
-    // Verifica se o diretório existe, caso contrário, cria-o
-    if (!std::filesystem::exists(directory)) {
-        std::filesystem::create_directory(directory);
-    }
 
-    // Caminho completo para o arquivo
-    const std::string file_path = directory + "/Output_Divergences.txt";
+// Converte o texto inteiro de uma opção numérica para o tipo do destino (false se sobrar texto ou não couber no tipo)
+template <class T>
+bool parseOptionValue(string_view text, T& value) {
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && error == errc() && end == text.data() + text.size();
+}
 
-    // Abre o arquivo para escrita
-    ofstream file(file_path);
-    
-    if(divergences.size() != 0) {
-        for (const auto& divergence : divergences) {
-            file << divergence << "\n";
+int runCommandLine(int argc, char* argv[]) {
+
+    std::string filename = "./netlists/ula_limpo.txt";
+    std::string filename1 = "./netlists/ula_trojan.txt";
+    size_t sweep_scenarios = 0; // --sweep K: propaga K cenários de entrada em lote
+    uint64_t sweep_seed = 1;    // --seed S: semente dos cenários aleatórios
+    std::string profiles_filename; // --profiles F: avalia todos os perfis de entrada do arquivo F
+    bool write_paths = true;       // --no-paths: grava apenas as estatísticas de caminhos, sem listar os caminhos
+    vector<string> trace_outputs;  // --trace-outputs L: saídas (IDs ou //nomes separados por vírgula) rastreadas mesmo sem divergir
+    bool trace_all = false;        // --trace-all: rastreia os caminhos de todas as saídas, não só das divergentes
+    bool exact = false;            // --exact: probabilidades exatas por tabela-verdade ou BDD (aproximação independente como reserva)
+    ExactOptions exact_options;    // --exhaustive-vars V, --bdd-budget N, --bdd-order dfs|id
+    uint64_t monte_carlo_samples = 0; // --monte-carlo N: simulação bit-paralela com N amostras (usa --seed)
+    unsigned num_threads = max(1u, std::thread::hardware_concurrency()); // --threads T
+    std::string delta_filename;    // --delta F: netlist trojan = netlist limpa + alterações de F (recalcula só o cone afetado)
+    std::string suspects_filename; // --suspects F: compara a netlist limpa com cada netlist listada em F, em paralelo
+    std::string manifest_filename; // --manifest F: executa todos os trabalhos do manifesto F em um único processo
+    bool localize = false;         // --localize: localiza os pontos de divergência internos por hash estrutural
+    DivergenceOptions divergence;  // --match-depth K, --abs-threshold A, --rel-threshold R, --top-k K, --rank-by dp1|kl|transition
+    size_t parse_benchmark_mb = 0;
+    std::string benchmark_directory; // --benchmark DIR: mede cada fase em todas as netlists de DIR (--warmup W, --repetitions N, --json F)
+    size_t benchmark_warmup = 2, benchmark_repetitions = 10;
+    std::string benchmark_json = "./Results/Benchmark.json"; // --parse-benchmark MB: mede a vazão do parser em uma netlist sintética de MB megabytes
+    std::string generate_prefix;     // --generate P: grava o par sintético P_limpo.txt / P_trojan.txt (--gen-* e --seed)
+    GeneratorOptions generator;
+    bool print_stats = false;        // --stats: imprime o tempo de cada fase e os contadores ao final
+    std::string stats_json;          // --stats-json F: grava a mesma instrumentação em JSON
+
+    // Argumentos: [netlist_limpa netlist_trojan] [--sweep K] [--seed S] [--profiles F] [--no-paths] [--trace-outputs L] [--trace-all] [--no-cache] [--exact] [--exhaustive-vars V] [--bdd-budget N] [--bdd-order dfs|id] [--monte-carlo N] [--threads T] [--match-depth K] [--abs-threshold A] [--rel-threshold R] [--top-k K] [--rank-by dp1|kl|transition] [--localize] [--stats] [--stats-json F]
+    //             [netlist_limpa] --delta F [demais opções]
+    //             [netlist_limpa] --suspects F [--exact] [--threads T] [--top-k K]
+    //             --manifest F [--exact]
+    //             --parse-benchmark MB [--seed S]
+    //             --benchmark DIR [--warmup W] [--repetitions N] [--json F]
+    //             --generate P [--gen-gates N] [--gen-depth D] [--gen-inputs I] [--gen-outputs O] [--gen-max-fanin F] [--gen-reconvergence R]
+    //                          [--gen-fanout-skew S] [--gen-mux-rate M] [--gen-sum-sub-rate A] [--gen-trojan-depth L] [--gen-trigger-width W] [--seed S]
+    vector<string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        // Valor numérico da opção (argv[++i]); texto inválido, negativo em opção sem sinal ou fora da faixa encerra com erro
+        auto parse = [&](auto& target) {
+            if (!parseOptionValue(argv[++i], target)) throw runtime_error("invalid value for " + arg);
+        };
+        if (arg == "--sweep" && i + 1 < argc) {
+            parse(sweep_scenarios);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            parse(sweep_seed);
+        } else if (arg == "--profiles" && i + 1 < argc) {
+            profiles_filename = argv[++i];
+        } else if (arg == "--no-cache") {
+            netlist_cache_enabled = false;
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            stats_json = argv[++i];
+        } else if (arg == "--no-paths") {
+            write_paths = false;
+        } else if (arg == "--trace-outputs" && i + 1 < argc) {
+            stringstream list(argv[++i]);
+            string ref;
+            while (getline(list, ref, ',')) {
+                if (!ref.empty()) trace_outputs.push_back(ref);
+            }
+        } else if (arg == "--trace-all") {
+            trace_all = true;
+        } else if (arg == "--monte-carlo" && i + 1 < argc) {
+            parse(monte_carlo_samples);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            parse(num_threads);
+            num_threads = max(1u, num_threads);
+        } else if (arg == "--suspects" && i + 1 < argc) {
+            suspects_filename = argv[++i];
+        } else if (arg == "--localize") {
+            localize = true;
+        } else if (arg == "--match-depth" && i + 1 < argc) {
+            parse(divergence.match_depth);
+            divergence.match_depth = max(1, divergence.match_depth);
+        } else if (arg == "--abs-threshold" && i + 1 < argc) {
+            parse(divergence.abs_threshold);
+            divergence.abs_threshold = max(0.0, divergence.abs_threshold);
+        } else if (arg == "--rel-threshold" && i + 1 < argc) {
+            parse(divergence.rel_threshold);
+            divergence.rel_threshold = max(0.0, divergence.rel_threshold);
+        } else if (arg == "--top-k" && i + 1 < argc) {
+            parse(divergence.top_k);
+        } else if (arg == "--rank-by" && i + 1 < argc) {
+            const string score = argv[++i];
+            const auto it = find(begin(SCORE_NAMES), end(SCORE_NAMES), score);
+            if (it == end(SCORE_NAMES)) {
+                cerr << "Error: Unknown divergence score " << score << endl;
+                return 1;
+            }
+            divergence.rank_by = DivergenceScore(it - begin(SCORE_NAMES));
+        } else if (arg == "--benchmark" && i + 1 < argc) {
+            benchmark_directory = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            parse(benchmark_warmup);
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            parse(benchmark_repetitions);
+            benchmark_repetitions = max<size_t>(1, benchmark_repetitions);
+        } else if (arg == "--json" && i + 1 < argc) {
+            benchmark_json = argv[++i];
+        } else if (arg == "--parse-benchmark" && i + 1 < argc) {
+            parse(parse_benchmark_mb);
+        } else if (arg == "--generate" && i + 1 < argc) {
+            generate_prefix = argv[++i];
+        } else if (arg == "--gen-gates" && i + 1 < argc) {
+            parse(generator.gates);
+        } else if (arg == "--gen-depth" && i + 1 < argc) {
+            parse(generator.depth);
+            generator.depth = max(1u, generator.depth);
+        } else if (arg == "--gen-inputs" && i + 1 < argc) {
+            parse(generator.inputs);
+            generator.inputs = max(1u, generator.inputs);
+        } else if (arg == "--gen-outputs" && i + 1 < argc) {
+            parse(generator.outputs);
+            generator.outputs = max(1u, generator.outputs);
+        } else if (arg == "--gen-max-fanin" && i + 1 < argc) {
+            parse(generator.max_fanin);
+            generator.max_fanin = max(2u, generator.max_fanin);
+        } else if (arg == "--gen-reconvergence" && i + 1 < argc) {
+            parse(generator.reconvergence);
+        } else if (arg == "--gen-fanout-skew" && i + 1 < argc) {
+            parse(generator.fanout_skew);
+        } else if (arg == "--gen-mux-rate" && i + 1 < argc) {
+            parse(generator.mux_rate);
+        } else if (arg == "--gen-sum-sub-rate" && i + 1 < argc) {
+            parse(generator.sum_sub_rate);
+        } else if (arg == "--gen-trojan-depth" && i + 1 < argc) {
+            parse(generator.trojan_depth);
+        } else if (arg == "--gen-trigger-width" && i + 1 < argc) {
+            parse(generator.trigger_width);
+            generator.trigger_width = max(1u, generator.trigger_width);
+        } else if (arg == "--manifest" && i + 1 < argc) {
+            manifest_filename = argv[++i];
+        } else if (arg == "--delta" && i + 1 < argc) {
+            delta_filename = argv[++i];
+        } else if (arg == "--exact") {
+            exact = true;
+        } else if (arg == "--exhaustive-vars" && i + 1 < argc) {
+            parse(exact_options.exhaustive_max_vars);
+            exact_options.exhaustive_max_vars = min(exact_options.exhaustive_max_vars, 40u);
+        } else if (arg == "--bdd-budget" && i + 1 < argc) {
+            parse(exact_options.bdd_node_budget);
+        } else if (arg == "--bdd-order" && i + 1 < argc) {
+            const string order = argv[++i];
+            if (order != "dfs" && order != "id") {
+                cerr << "Error: Unknown BDD ordering " << order << endl;
+                return 1;
+            }
+            exact_options.ordering = order == "dfs" ? BDD_ORDER_DFS : BDD_ORDER_ID;
+        } else if (arg.rfind("--", 0) == 0) {
+            cerr << "Error: Unknown option " << arg << endl;
+            return 1;
+        } else {
+            positional.push_back(arg);
         }
-    } else {
-        file << "No divergences were found!";
+    }
+    const bool manifest_conflict = !manifest_filename.empty() && (!positional.empty() || !suspects_filename.empty() || !delta_filename.empty());
+    if (positional.size() == 2 && delta_filename.empty() && !manifest_conflict) {
+        filename = positional[0];
+        filename1 = positional[1];
+    } else if (positional.size() == 1 && (!delta_filename.empty() || !suspects_filename.empty()) && !manifest_conflict) {
+        filename = positional[0];
+    } else if (!positional.empty() || manifest_conflict) {
+        cerr << "Usage: " << argv[0] << " [clean_netlist trojan_netlist] [--sweep K] [--seed S] [--profiles F] [--no-paths] [--trace-outputs L] [--trace-all] [--no-cache] [--exact] [--exhaustive-vars V] [--bdd-budget N] [--bdd-order dfs|id] [--monte-carlo N] [--threads T] [--match-depth K] [--abs-threshold A] [--rel-threshold R] [--top-k K] [--rank-by dp1|kl|transition] [--localize] [--stats] [--stats-json F]" << endl;
+        cerr << "       " << argv[0] << " [clean_netlist] --delta F [options]" << endl;
+        cerr << "       " << argv[0] << " [clean_netlist] --suspects F [--exact] [--threads T] [--top-k K]" << endl;
+        cerr << "       " << argv[0] << " --manifest F [--exact]" << endl;
+        cerr << "       " << argv[0] << " --parse-benchmark MB [--seed S]" << endl;
+        cerr << "       " << argv[0] << " --benchmark DIR [--warmup W] [--repetitions N] [--json F]" << endl;
+        cerr << "       " << argv[0] << " --generate P [--gen-gates N] [--gen-depth D] [--gen-inputs I] [--gen-outputs O] [--gen-max-fanin F] [--gen-reconvergence R] [--gen-fanout-skew S] [--gen-mux-rate M] [--gen-sum-sub-rate A] [--gen-trojan-depth L] [--gen-trigger-width W] [--seed S]" << endl;
+        return 1;
     }
 
-    file.close();
-}
-
-
+    instrumentation.enabled = print_stats || !stats_json.empty();
+    heap_counters.counting = instrumentation.enabled;
 
+    Netlist netlist1, netlist2;
+    PathDag output_paths1, output_paths2;
 
+    // <<-- 2. Inicia o cronômetro
+    auto start = std::chrono::high_resolution_clock::now();
 
-// Função para salvar as probabilidades de transição em um arquivo
-void saveTransitionProbabilities(const map<int, Element>& netlist, const string& output_filename, string source_directory) {
-    // Diretório onde o arquivo será salvo
-    const std::string directory = "./" + source_directory + "/Table_Transitions/";
-    
-    // Verifica se o diretório existe, caso contrário, cria-o
-    if (!std::filesystem::exists(directory)) {
-        std::filesystem::create_directory(directory);
+    // Medição do parser: não lê as netlists de entrada
+    if (parse_benchmark_mb > 0) {
+        runParseBenchmark(parse_benchmark_mb, sweep_seed);
+        return 0;
     }
 
-    // Caminho completo para o arquivo
-    const std::string file_path = directory + output_filename + ".txt";
-
-    // Abre o arquivo para escrita
-    ofstream output_file(file_path);
-
-    if (!output_file.is_open()) {
-        cerr << "Error opening file " << output_filename << " for writing!" << endl;
-        return;
+    // Gerador sintético: não lê as netlists de entrada
+    if (!generate_prefix.empty()) {
+        generator.seed = sweep_seed;
+        generateNetlistPair(generator, generate_prefix);
+        return 0;
     }
 
-    output_file << "Element\tTransition Probability\n";
-    for (const auto& [id, elem] : netlist) {
-        double transition_prob = elem.prob_0 * elem.prob_1;
-        output_file << "   " << id << "\t\t      " << transition_prob << "\n";
+    // Benchmark por fase de todas as netlists de um diretório
+    if (!benchmark_directory.empty()) {
+        runBenchmark(benchmark_directory, benchmark_warmup, benchmark_repetitions, benchmark_json);
+        return 0;
     }
 
+    // Modo de lote: todos os trabalhos do manifesto no mesmo processo, compartilhando as netlists repetidas
+    if (!manifest_filename.empty()) {
+        const size_t failed = runManifest(parseManifest(manifest_filename), exact, exact_options, divergence);
 
-    output_file.close();
-}
-
-
-
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        std::cout << "Tempo de execução: " << duration.count() << " us" << std::endl;
+        reportInstrumentation(print_stats, stats_json);
+        return failed > 0 ? 1 : 0;
+    }
 
+    // Modo de triagem: uma netlist de referência contra muitas suspeitas, sem os demais relatórios
+    if (!suspects_filename.empty()) {
+        compareSuspects(filename, parseSuspectList(suspects_filename), exact, exact_options, divergence, num_threads, "./Results");
 
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        std::cout << "Tempo de execução: " << duration.count() << " us" << std::endl;
+        reportInstrumentation(print_stats, stats_json);
+        return 0;
+    }
 
-int main() {
+    if (delta_filename.empty()) {
+        parseNetlist(filename, netlist1);
+        parseNetlist(filename1, netlist2);
 
-    std::string filename = "./netlists/ula_limpo.txt";
-    std::string filename1 = "./netlists/ula_trojan.txt";
-    std::map<int, Element> netlist1, netlist2;
-    std::map<int, std::vector<std::vector<int>>> output_paths1, output_paths2;
-    
-    // <<-- 2. Inicia o cronômetro
-    auto start = std::chrono::high_resolution_clock::now();
-    parseNetlist(filename, netlist1);
-    parseNetlist(filename1, netlist2);
+        calculateProbabilities(netlist1);
+        calculateProbabilities(netlist2);
+    } else {
+        // Netlist trojan derivada da limpa já propagada: só o cone dos elementos alterados é recalculado
+        parseNetlist(filename, netlist1);
+        calculateProbabilities(netlist1);
+        netlist2 = netlist1;
+        applyNetlistDelta(netlist2, parseNetlistDelta(delta_filename, netlist2));
+    }
 
-    calculateProbabilities(netlist1);
-    calculateProbabilities(netlist2);
+    // Modo exato: substitui a aproximação independente quando o BDD cabe no orçamento
+    if (exact) {
+        calculateExactProbabilities(netlist1, exact_options);
+        calculateExactProbabilities(netlist2, exact_options);
+    }
 
-    findPathsForOutputs(netlist1, output_paths1);
-    findPathsForOutputs(netlist2, output_paths2);
+    const DivergenceReport divergences = compareProbabilities(netlist1, netlist2, divergence);
 
-    auto divergences = compareProbabilitiesWithPaths(netlist1, netlist2, output_paths1, output_paths2);
+    // Caminhos sob demanda: só as saídas do relatório de divergências e as pedidas em --trace-outputs (todas com --trace-all)
+    if (trace_all) {
+        findPathsForOutputs(netlist1, output_paths1);
+        findPathsForOutputs(netlist2, output_paths2);
+    } else {
+        vector<int> traced1 = reportedOutputs(divergences, 1), traced2 = reportedOutputs(divergences, 2);
+        vector<char> found(trace_outputs.size(), 0);
+        addRequestedOutputs(netlist1, trace_outputs, traced1, found);
+        addRequestedOutputs(netlist2, trace_outputs, traced2, found);
+        for (size_t k = 0; k < trace_outputs.size(); ++k) {
+            if (!found[k]) cerr << "Warning: Output " << trace_outputs[k] << " given to --trace-outputs was not found" << endl;
+        }
+        findPathsForOutputs(netlist1, output_paths1, &traced1);
+        findPathsForOutputs(netlist2, output_paths2, &traced2);
+    }
 
     const std::string directory = "./Results";
     
@@ -649,13 +4917,65 @@ int main() {
         std::filesystem::create_directory(directory);
     }
 
-    displayOutputPaths(output_paths1, netlist1, "_Netlist_Limpa", directory);
-    displayOutputPaths(output_paths2, netlist2, "_Netlist_Trojan", directory);
+    if (write_paths) {
+        displayOutputPaths(output_paths1, netlist1, "_Netlist_Limpa", directory);
+        displayOutputPaths(output_paths2, netlist2, "_Netlist_Trojan", directory);
+    }
+
+    PathStats path_stats1, path_stats2;
+    computePathStatistics(netlist1, path_stats1);
+    computePathStatistics(netlist2, path_stats2);
+    savePathStatistics(path_stats1, output_paths1, netlist1, "_Netlist_Limpa", directory);
+    savePathStatistics(path_stats2, output_paths2, netlist2, "_Netlist_Trojan", directory);
 
-    saveDivergences(divergences, directory);
+    saveDivergences(divergences, netlist1, netlist2, directory);
+    if (localize) {
+        saveLocalization(localizeDivergences(netlist1, netlist2, divergence.match_depth), netlist1, netlist2, directory);
+    }
 
     saveTransitionProbabilities(netlist1, "Prob_Netlist_Limpa", directory);
     saveTransitionProbabilities(netlist2, "Prob_Netlist_Trojan", directory);
+
+    // Varredura em lote: os K cenários de cada netlist são propagados em uma única travessia
+    if (sweep_scenarios > 0) {
+        ScenarioBatch batch1 = createScenarioBatch(netlist1, sweep_scenarios);
+        ScenarioBatch batch2 = createScenarioBatch(netlist2, sweep_scenarios);
+        fillRandomScenarios(netlist1, batch1, sweep_seed);
+        fillRandomScenarios(netlist2, batch2, sweep_seed);
+
+        calculateProbabilitiesBatch(netlist1, batch1);
+        calculateProbabilitiesBatch(netlist2, batch2);
+
+        saveBatchProbabilities(netlist1, batch1, "Batch_Netlist_Limpa", directory);
+        saveBatchProbabilities(netlist2, batch2, "Batch_Netlist_Trojan", directory);
+    }
+
+    // Monte Carlo: verificação cruzada das probabilidades, correta mesmo com fanout reconvergente
+    if (monte_carlo_samples > 0) {
+        MonteCarloResult monte_carlo1, monte_carlo2;
+        if (simulateMonteCarlo(netlist1, monte_carlo_samples, sweep_seed, num_threads, monte_carlo1)) {
+            saveMonteCarloProbabilities(monte_carlo1, netlist1, "Monte_Carlo_Netlist_Limpa", directory);
+        }
+        if (simulateMonteCarlo(netlist2, monte_carlo_samples, sweep_seed, num_threads, monte_carlo2)) {
+            saveMonteCarloProbabilities(monte_carlo2, netlist2, "Monte_Carlo_Netlist_Trojan", directory);
+        }
+    }
+
+    // Perfis de entrada: todos os perfis do arquivo são avaliados em um único lote, reaproveitando
+    // as netlists já lidas e levelizadas
+    if (!profiles_filename.empty()) {
+        const vector<ProbabilityProfile> profiles = parseProfiles(profiles_filename);
+        if (!profiles.empty()) {
+            ScenarioBatch batch1 = createProfileBatch(netlist1, profiles);
+            ScenarioBatch batch2 = createProfileBatch(netlist2, profiles);
+
+            calculateProbabilitiesBatch(netlist1, batch1);
+            calculateProbabilitiesBatch(netlist2, batch2);
+
+            saveBatchProbabilities(netlist1, batch1, "Profiles_Netlist_Limpa", directory);
+            saveBatchProbabilities(netlist2, batch2, "Profiles_Netlist_Trojan", directory);
+        }
+    }
  
     // <<-- 3. Para o cronômetro
     auto end = std::chrono::high_resolution_clock::now();
@@ -665,6 +4985,17 @@ int main() {
 
     // <<-- 5. Imprime o tempo de execução
     std::cout << "Tempo de execução: " << duration.count() << " us" << std::endl;
+    reportInstrumentation(print_stats, stats_json);
 
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    // Erros de leitura (netlist inexistente ou malformada, arquivos de opções) encerram a execução com código 1
+    try {
+        return runCommandLine(argc, argv);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
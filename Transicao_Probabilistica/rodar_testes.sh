@@ -0,0 +1,11 @@
+#!/bin/sh
+# Benchmark por fase (leitura, propagação, caminhos, comparação e gravação dos relatórios) de todas as netlists
+# de ./netlists, medido dentro do processo. Uso: ./rodar_testes.sh [repetições] [arquivo.json]
+set -e
+cd "$(dirname "$0")"
+
+REPETITIONS=${1:-100}
+JSON=${2:-./Results/Benchmark.json}
+
+g++ -O2 -march=native -std=c++17 main.cpp -o main
+./main --benchmark ./netlists --warmup 3 --repetitions "$REPETITIONS" --json "$JSON"